@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_BENCH_BENCH_HPP
+#define ASIOFY_BENCH_BENCH_HPP
+
+#include <asiofy/libssh/error.hpp>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+
+namespace net = boost::asio;
+using asiofy::libssh::error_code;
+
+using clock = std::chrono::steady_clock;
+
+inline double seconds_since(clock::time_point start)
+{
+  return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+/// The `p`th percentile of `samples`, with p in [0, 1]. Sorts the samples.
+inline double percentile(std::vector<double> & samples, double p)
+{
+  if (samples.empty())
+    return 0.;
+  std::sort(samples.begin(), samples.end());
+  const auto idx = static_cast<std::size_t>(p * (samples.size() - 1u) + 0.5);
+  return samples[(std::min)(idx, samples.size() - 1u)];
+}
+
+/// One line of the report, i.e. a flat JSON object of numbers & strings.
+struct result
+{
+  std::vector<std::pair<std::string, std::string>> fields;
+
+  result & set(std::string key, std::string value)
+  {
+    fields.emplace_back(std::move(key), '"' + std::move(value) + '"');
+    return *this;
+  }
+
+  result & set(std::string key, double value)
+  {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    fields.emplace_back(std::move(key), buf);
+    return *this;
+  }
+};
+
+/// Collects the results of a benchmark executable & prints them as one JSON document, to be diffed between releases.
+struct report
+{
+  explicit report(std::string name) : name(std::move(name)) {}
+
+  void add(result r) { results.push_back(std::move(r)); }
+
+  void print(std::FILE * out = stdout) const
+  {
+    std::fprintf(out, "{\"benchmark\": \"%s\", \"results\": [", name.c_str());
+    for (std::size_t i = 0u; i < results.size(); i++)
+    {
+      std::fprintf(out, i == 0u ? "\n  {" : ",\n  {");
+      const auto & fields = results[i].fields;
+      for (std::size_t j = 0u; j < fields.size(); j++)
+        std::fprintf(out, "%s\"%s\": %s", j == 0u ? "" : ", ", fields[j].first.c_str(), fields[j].second.c_str());
+      std::fprintf(out, "}");
+    }
+    std::fprintf(out, "\n]}\n");
+  }
+
+  std::string name;
+  std::vector<result> results;
+};
+
+/// Write `total` bytes to `stream` in chunks of at most `chunk.size()`.
+template<typename Stream>
+void async_write_n(Stream & stream, net::const_buffer chunk, std::size_t total, std::function<void(error_code)> done)
+{
+  if (total == 0u)
+    return done(error_code{});
+
+  const auto n = (std::min)(total, chunk.size());
+  net::async_write(stream, net::buffer(chunk, n),
+                   [&stream, chunk, total, done](error_code ec, std::size_t written) mutable
+                   {
+                     if (ec)
+                       return done(ec);
+                     async_write_n(stream, chunk, total - written, std::move(done));
+                   });
+}
+
+/// Read & discard `total` bytes from `stream` into `chunk`.
+template<typename Stream>
+void async_read_n(Stream & stream, net::mutable_buffer chunk, std::size_t total, std::function<void(error_code)> done)
+{
+  if (total == 0u)
+    return done(error_code{});
+
+  stream.async_read_some(net::buffer(chunk, (std::min)(total, chunk.size())),
+                         [&stream, chunk, total, done](error_code ec, std::size_t read) mutable
+                         {
+                           if (ec)
+                             return done(ec);
+                           async_read_n(stream, chunk, total - read, std::move(done));
+                         });
+}
+
+}
+
+#endif //ASIOFY_BENCH_BENCH_HPP
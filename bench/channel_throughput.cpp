@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Measures basic_channel throughput & latency over the in-process loopback,
+// for every cipher suite below. Usage: channel_throughput [megabytes] [channels] [round_trips]
+
+#include "bench.hpp"
+#include "../test/loopback.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+
+using bench::error_code;
+
+struct cipher_suite
+{
+  const char * cipher;
+  const char * hmac; // ignored by the AEAD ciphers
+};
+
+const cipher_suite cipher_suites[] = {
+    {"aes128-ctr",                    "hmac-sha2-256"},
+    {"aes128-ctr",                    "hmac-sha2-256-etm@openssh.com"},
+    {"aes256-ctr",                    "hmac-sha2-512"},
+    {"aes256-gcm@openssh.com",        "hmac-sha2-256"},
+    {"chacha20-poly1305@openssh.com", "hmac-sha2-256"},
+};
+
+constexpr std::size_t chunk_size = 32768u;
+
+std::unique_ptr<loopback> connect(const cipher_suite & cs)
+{
+  using namespace asiofy::libssh;
+  std::unique_ptr<loopback> lb{new loopback(SSH_KEYTYPE_ED25519,
+                                            ciphers_c_s{cs.cipher}, ciphers_s_c{cs.cipher},
+                                            hmac_c_s{cs.hmac},      hmac_s_c{cs.hmac})};
+  lb->client.options_set(SSH_OPTIONS_CIPHERS_C_S, cs.cipher);
+  lb->client.options_set(SSH_OPTIONS_CIPHERS_S_C, cs.cipher);
+  lb->client.options_set(SSH_OPTIONS_HMAC_C_S, cs.hmac);
+  lb->client.options_set(SSH_OPTIONS_HMAC_S_C, cs.hmac);
+  lb->connect();
+  return lb;
+}
+
+void check(error_code ec, const char * what)
+{
+  if (ec)
+    throw asiofy::libssh::system_error(ec, what);
+}
+
+bench::result describe(const char * name, const cipher_suite & cs)
+{
+  bench::result r;
+  r.set("case", name).set("cipher", cs.cipher).set("hmac", cs.hmac);
+  return r;
+}
+
+// one channel, client to server. stderr only flows from the server to the client.
+bench::result bulk(const cipher_suite & cs, std::size_t total, bool use_stderr)
+{
+  auto lb = connect(cs);
+  auto chan = lb->open_channel();
+  auto & peer = lb->server_channels.back();
+
+  auto out = use_stderr ? peer.get_stderr() : chan.get_stdout();
+  auto in  = use_stderr ? chan.get_stderr() : peer.get_stdout();
+
+  std::vector<char> write_buf(chunk_size, 'x'), read_buf(chunk_size);
+  error_code write_ec, read_ec;
+  int pending = 2;
+
+  const auto start = bench::clock::now();
+  bench::async_write_n(out, net::buffer(write_buf), total, [&](error_code ec) { write_ec = ec; pending--; });
+  bench::async_read_n (in,  net::buffer(read_buf),  total, [&](error_code ec) { read_ec  = ec; pending--; });
+  lb->run_until([&]{ return pending == 0; });
+  const auto secs = bench::seconds_since(start);
+
+  check(write_ec, "write");
+  check(read_ec, "read");
+  return describe(use_stderr ? "stderr" : "bulk", cs)
+      .set("bytes", static_cast<double>(total))
+      .set("seconds", secs)
+      .set("mb_per_s", total / secs / 1e6);
+}
+
+// `channels` channels on one session, each transferring its share of `total` at the same time.
+bench::result parallel(const cipher_suite & cs, std::size_t total, std::size_t channels)
+{
+  auto lb = connect(cs);
+  std::deque<loopback::channel_type> chans;
+  for (std::size_t i = 0u; i < channels; i++)
+    chans.push_back(lb->open_channel());
+
+  using stream_type = decltype(chans.front().get_stdout());
+  std::vector<stream_type> outs, ins;
+  for (std::size_t i = 0u; i < channels; i++)
+  {
+    outs.push_back(chans[i].get_stdout());
+    ins.push_back(lb->server_channels[i].get_stdout());
+  }
+
+  const auto share = total / channels;
+  std::vector<char> write_buf(chunk_size, 'x'), read_buf(chunk_size * channels);
+  error_code error;
+  std::size_t pending = channels * 2u;
+  auto on_done = [&](error_code ec) { if (ec) error = ec; pending--; };
+
+  const auto start = bench::clock::now();
+  for (std::size_t i = 0u; i < channels; i++)
+  {
+    bench::async_write_n(outs[i], net::buffer(write_buf), share, on_done);
+    bench::async_read_n(ins[i], net::buffer(read_buf.data() + i * chunk_size, chunk_size), share, on_done);
+  }
+  lb->run_until([&]{ return pending == 0u; });
+  const auto secs = bench::seconds_since(start);
+
+  check(error, "parallel transfer");
+  return describe("parallel", cs)
+      .set("channels", static_cast<double>(channels))
+      .set("bytes", static_cast<double>(share * channels))
+      .set("seconds", secs)
+      .set("mb_per_s", share * channels / secs / 1e6);
+}
+
+// the client sends `size` bytes, the server echoes them back, `round_trips` times.
+bench::result ping_pong(const cipher_suite & cs, std::size_t round_trips, std::size_t size)
+{
+  auto lb = connect(cs);
+  auto chan = lb->open_channel();
+  auto & peer = lb->server_channels.back();
+
+  auto client = chan.get_stdout();
+  auto server = peer.get_stdout();
+  std::vector<char> ping(size, 'p'), server_buf(size), client_buf(size);
+
+  error_code error;
+  bool done = false;
+  std::size_t left = round_trips;
+  std::function<void(error_code)> step =
+      [&](error_code ec)
+      {
+        if (ec || left-- == 0u)
+        {
+          error = ec;
+          done = true;
+          return;
+        }
+        net::async_write(client, net::buffer(ping), [&](error_code ec, std::size_t)
+        {
+          if (ec) return step(ec);
+          net::async_read(server, net::buffer(server_buf), [&](error_code ec, std::size_t)
+          {
+            if (ec) return step(ec);
+            net::async_write(server, net::buffer(server_buf), [&](error_code ec, std::size_t)
+            {
+              if (ec) return step(ec);
+              net::async_read(client, net::buffer(client_buf), [&](error_code ec, std::size_t) { step(ec); });
+            });
+          });
+        });
+      };
+
+  const auto start = bench::clock::now();
+  step(error_code{});
+  lb->run_until([&]{ return done; });
+  const auto secs = bench::seconds_since(start);
+
+  check(error, "ping pong");
+  return describe("ping_pong", cs)
+      .set("message_size", static_cast<double>(size))
+      .set("round_trips", static_cast<double>(round_trips))
+      .set("seconds", secs)
+      .set("us_per_round_trip", secs * 1e6 / round_trips)
+      .set("mb_per_s", 2.0 * size * round_trips / secs / 1e6);
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+  const std::size_t megabytes   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64u;
+  const std::size_t channels    = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8u;
+  const std::size_t round_trips = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10000u;
+  const std::size_t total = megabytes * 1024u * 1024u;
+
+  bench::report report{"channel_throughput"};
+  try
+  {
+    for (const auto & cs : cipher_suites)
+    {
+      report.add(bulk(cs, total, false));
+      report.add(parallel(cs, total, channels));
+      report.add(ping_pong(cs, round_trips, 64u));
+      report.add(bulk(cs, total, true));
+    }
+  }
+  catch (std::exception & e)
+  {
+    std::cerr << "channel_throughput failed: " << e.what() << std::endl;
+    return 1;
+  }
+  report.print();
+  return 0;
+}
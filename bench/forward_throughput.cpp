@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Measures the connection rate & throughput of local (`ssh -L`) and reverse (`ssh -R`) forwarding
+// over the in-process loopback. Usage: forward_throughput [megabytes] [connections]
+
+#include "bench.hpp"
+#include "../test/loopback.hpp"
+
+#include <asiofy/libssh/forward.hpp>
+#include <asiofy/libssh/reverse_forward.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <deque>
+#include <stdexcept>
+
+namespace
+{
+
+using bench::error_code;
+using executor_type  = net::io_context::executor_type;
+using acceptor_type  = net::basic_socket_acceptor<net::ip::tcp, executor_type>;
+using forwarder_type = asiofy::libssh::basic_reverse_forwarder<executor_type>;
+
+constexpr std::size_t chunk_size = 32768u;
+
+void check(error_code ec, const char * what)
+{
+  if (ec)
+    throw asiofy::libssh::system_error(ec, what);
+}
+
+// the forwarded connections hold channels, so they need to be done before the loopback goes away.
+void finish(loopback & lb, std::deque<loopback::channel_type> & channels)
+{
+  error_code ig;
+  asiofy::libssh::error_info ei;
+  for (auto & chan : channels)
+    if (chan.is_open())
+      chan.close(ig, ei);
+  lb.ctx.restart();
+  lb.ctx.run_for(std::chrono::milliseconds(100));
+}
+
+// moves `total` bytes from `source` to `sink` & returns the seconds it took.
+template<typename Source, typename Sink>
+double transfer(loopback & lb, Source & source, Sink & sink, std::size_t total)
+{
+  std::vector<char> write_buf(chunk_size, 'x'), read_buf(chunk_size);
+  error_code write_ec, read_ec;
+  int pending = 2;
+
+  const auto start = bench::clock::now();
+  bench::async_write_n(source, net::buffer(write_buf), total, [&](error_code ec) { write_ec = ec; pending--; });
+  bench::async_read_n (sink,   net::buffer(read_buf),  total, [&](error_code ec) { read_ec  = ec; pending--; });
+  lb.run_until([&]{ return pending == 0; });
+  const auto secs = bench::seconds_since(start);
+
+  check(write_ec, "write");
+  check(read_ec, "read");
+  return secs;
+}
+
+// waits until the first byte sent through a fresh connection arrives at `sink`.
+template<typename Sink>
+void first_byte(loopback & lb, net::ip::tcp::socket & sock, Sink & sink)
+{
+  char out = 'x', in = 0;
+  error_code write_ec, read_ec;
+  int pending = 2;
+  net::async_write(sock, net::buffer(&out, 1u), [&](error_code ec, std::size_t) { write_ec = ec; pending--; });
+  net::async_read(sink, net::buffer(&in, 1u), [&](error_code ec, std::size_t) { read_ec = ec; pending--; });
+  lb.run_until([&]{ return pending == 0; });
+  check(write_ec, "first byte write");
+  check(read_ec, "first byte read");
+}
+
+struct local_forward
+{
+  loopback lb;
+  acceptor_type acceptor{lb.ctx.get_executor(), net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u)};
+
+  local_forward()
+  {
+    lb.connect();
+    asiofy::libssh::async_forward_local(lb.client, acceptor, "127.0.0.1", 80, [](error_code) {});
+  }
+
+  ~local_forward()
+  {
+    error_code ig;
+    acceptor.close(ig);
+    finish(lb, lb.server_channels);
+    lb.server_channels.clear();
+  }
+
+  // connects through the forward & returns the stream of the channel at the server.
+  loopback::channel_type::stdreader connect(net::ip::tcp::socket & sock)
+  {
+    const auto opened = lb.server_channels.size() + 1u;
+    sock.connect(acceptor.local_endpoint());
+    lb.run_until([&]{ return lb.server_channels.size() == opened; });
+    return lb.server_channels.back().get_stdout();
+  }
+};
+
+// the client side of the reverse forward is plain libssh, driven by waiting for its socket in between calls.
+struct reverse_forward
+{
+  loopback lb;
+  forwarder_type fwd{lb.server};
+  std::deque<loopback::channel_type> channels;
+  int port = 0;
+
+  reverse_forward()
+  {
+    lb.on_message = [this](loopback::session_type &, ssh_message msg) { return fwd.handle_message(msg); };
+    lb.connect();
+
+    int res;
+    while ((res = ssh_channel_listen_forward(lb.client.native_handle(), "127.0.0.1", 0, &port)) == SSH_AGAIN)
+      wait_for_client();
+    if (res != SSH_OK)
+      throw std::runtime_error("tcpip-forward got refused");
+  }
+
+  ~reverse_forward()
+  {
+    fwd.close();
+    finish(lb, channels);
+    channels.clear();
+  }
+
+  void wait_for_client()
+  {
+    bool woken = false;
+    lb.client.next_layer().async_wait(net::socket_base::wait_read, [&](error_code) { woken = true; });
+    lb.run_until([&]{ return woken; });
+  }
+
+  // connects to the forwarded port & returns the stream of the channel at the client.
+  loopback::channel_type::stdreader connect(net::ip::tcp::socket & sock)
+  {
+    sock.connect(net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), static_cast<unsigned short>(port)));
+    ssh_channel chan;
+    while ((chan = ssh_channel_accept_forward(lb.client.native_handle(), 0, nullptr)) == nullptr)
+      wait_for_client();
+    channels.emplace_back(lb.client, chan);
+    return channels.back().get_stdout();
+  }
+};
+
+// every connection gets accepted, opens its channel & delivers its first byte, before it gets closed.
+template<typename Forward>
+bench::result connection_rate(const char * name, std::size_t connections)
+{
+  Forward fwd;
+  const auto start = bench::clock::now();
+  for (std::size_t i = 0u; i < connections; i++)
+  {
+    net::ip::tcp::socket sock{fwd.lb.ctx};
+    auto peer = fwd.connect(sock);
+    first_byte(fwd.lb, sock, peer);
+  }
+  const auto secs = bench::seconds_since(start);
+
+  bench::result r;
+  return r.set("case", name)
+      .set("connections", static_cast<double>(connections))
+      .set("seconds", secs)
+      .set("connections_per_s", connections / secs);
+}
+
+// one connection, from the socket to the far end of the channel.
+template<typename Forward>
+bench::result throughput(const char * name, std::size_t total)
+{
+  Forward fwd;
+  net::ip::tcp::socket sock{fwd.lb.ctx};
+  auto peer = fwd.connect(sock);
+  const auto secs = transfer(fwd.lb, sock, peer, total);
+
+  bench::result r;
+  return r.set("case", name)
+      .set("bytes", static_cast<double>(total))
+      .set("seconds", secs)
+      .set("mb_per_s", total / secs / 1e6);
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+  const std::size_t megabytes   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64u;
+  const std::size_t connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000u;
+  const std::size_t total = megabytes * 1024u * 1024u;
+
+  bench::report report{"forward_throughput"};
+  try
+  {
+    report.add(connection_rate<local_forward>("local_connection_rate", connections));
+    report.add(throughput<local_forward>("local_throughput", total));
+    report.add(connection_rate<reverse_forward>("reverse_connection_rate", connections));
+    report.add(throughput<reverse_forward>("reverse_throughput", total));
+  }
+  catch (std::exception & e)
+  {
+    std::cerr << "forward_throughput failed: " << e.what() << std::endl;
+    return 1;
+  }
+  report.print();
+  return 0;
+}
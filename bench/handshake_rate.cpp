@@ -0,0 +1,240 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Measures how many connections a basic_bind can take per second: local TCP clients connect concurrently,
+// every accepted session gets its own strand & the server records the time from accept to authenticated.
+// Usage: handshake_rate [connections] [concurrency]
+
+#include "bench.hpp"
+
+#include <asiofy/libssh/bind.hpp>
+#include <asiofy/libssh/message.hpp>
+#include <asiofy/libssh/server.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace net = boost::asio;
+
+namespace
+{
+
+using bench::error_code;
+using session_type = asiofy::libssh::basic_session<net::strand<net::io_context::executor_type>>;
+
+struct host_key
+{
+  ssh_keytypes_e type;
+  int bits;
+  const char * algorithm;
+};
+
+const char * const key_exchanges[] = {
+    "curve25519-sha256",
+    "ecdh-sha2-nistp256",
+    "diffie-hellman-group14-sha256",
+};
+
+const host_key host_keys[] = {
+    {SSH_KEYTYPE_ED25519, 0,    "ssh-ed25519"},
+    {SSH_KEYTYPE_ECDSA,   256,  "ecdsa-sha2-nistp256"},
+    {SSH_KEYTYPE_RSA,     2048, "rsa-sha2-256"},
+};
+
+struct run_state
+{
+  net::io_context ctx;
+  asiofy::libssh::basic_bind<net::io_context::executor_type> bind{ctx.get_executor()};
+  net::generic::stream_protocol::endpoint endpoint;
+  const char * kex;
+  const char * host_key_algorithm;
+  std::size_t total;
+
+  std::atomic<std::size_t> started{0u};
+  std::atomic<std::size_t> finished{0u};
+  std::atomic<std::size_t> failed{0u};
+
+  std::mutex mutex;
+  std::vector<double> latencies; // accept to authenticated, in seconds
+
+  void record(bench::clock::time_point accepted)
+  {
+    const auto latency = bench::seconds_since(accepted);
+    std::lock_guard<std::mutex> lock{mutex};
+    latencies.push_back(latency);
+  }
+
+  void client_done(error_code ec)
+  {
+    if (ec)
+      failed++;
+    if (++finished == total)
+      ctx.stop();
+  }
+};
+
+// answer the authentication, then keep the session alive until the client disconnects.
+void serve(run_state & st, std::shared_ptr<session_type> sess, bench::clock::time_point accepted)
+{
+  asiofy::libssh::async_get_message(
+      *sess,
+      [&st, sess, accepted](error_code ec, asiofy::libssh::message_handle msg)
+      {
+        if (ec)
+          return;
+        if (ssh_message_type(msg.get()) == SSH_REQUEST_AUTH)
+        {
+          ssh_message_auth_reply_success(msg.get(), 0);
+          st.record(accepted);
+        }
+        else
+          ssh_message_reply_default(msg.get());
+        serve(st, std::move(sess), accepted);
+      });
+}
+
+void accept(run_state & st)
+{
+  st.bind.async_accept(
+      net::make_strand(st.ctx),
+      [&st](error_code ec, session_type sess)
+      {
+        const auto accepted = bench::clock::now();
+        if (ec)
+          return;
+        accept(st);
+
+        auto s = std::make_shared<session_type>(std::move(sess));
+        asiofy::libssh::async_handle_key_exchange(
+            *s,
+            [&st, s, accepted](error_code ec)
+            {
+              if (!ec)
+                serve(st, std::move(s), accepted);
+            });
+      });
+}
+
+void connect_client(run_state & st)
+{
+  if (st.started++ >= st.total)
+    return;
+
+  auto sess = std::make_shared<session_type>(net::make_strand(st.ctx));
+  sess->options_set(SSH_OPTIONS_HOST, "127.0.0.1");
+  sess->options_set(SSH_OPTIONS_PROCESS_CONFIG, 0);
+  sess->options_set(SSH_OPTIONS_KEY_EXCHANGE, st.kex);
+  sess->options_set(SSH_OPTIONS_HOSTKEYS, st.host_key_algorithm);
+
+  auto done = [&st, sess](error_code ec)
+  {
+    sess->disconnect();
+    st.client_done(ec);
+    connect_client(st);
+  };
+
+  sess->next_layer().async_connect(
+      st.endpoint,
+      [sess, done](error_code ec)
+      {
+        if (ec)
+          return done(ec);
+        sess->async_connect(
+            [sess, done](error_code ec)
+            {
+              if (ec)
+                return done(ec);
+              asiofy::libssh::detail::async_auth_op(
+                  *sess, [](ssh_session s) { return ssh_userauth_none(s, nullptr); }, nullptr, done);
+            });
+      });
+}
+
+bench::result run(const char * kex, const host_key & key, std::size_t threads,
+                  std::size_t total, std::size_t concurrency)
+{
+  using namespace asiofy::libssh;
+  run_state st;
+  st.kex = kex;
+  st.host_key_algorithm = key.algorithm;
+  st.total = total;
+  st.latencies.reserve(total);
+
+  ssh_key hk = nullptr;
+  if (ssh_pki_generate(key.type, key.bits, &hk) != SSH_OK)
+    throw std::runtime_error("ssh_pki_generate failed");
+  st.bind.options_set(SSH_BIND_OPTIONS_IMPORT_KEY, hk);
+  const auto options = make_options(bindaddr{"127.0.0.1"}, bindport{0u}, process_config{false},
+                                    key_exchange{kex}, hostkey_algorithms{key.algorithm});
+  if (!options.valid() || !apply_config(st.bind, options))
+    throw std::runtime_error("invalid bind option");
+  st.bind.listen();
+  st.endpoint = st.bind.next_layer().local_endpoint();
+
+  accept(st);
+  const auto start = bench::clock::now();
+  for (std::size_t i = 0u; i < concurrency; i++)
+    connect_client(st);
+
+  std::vector<std::thread> pool;
+  for (std::size_t i = 1u; i < threads; i++)
+    pool.emplace_back([&]{ st.ctx.run(); });
+  st.ctx.run();
+  for (auto & t : pool)
+    t.join();
+  const auto secs = bench::seconds_since(start);
+
+  bench::result r;
+  r.set("key_exchange", kex)
+   .set("hostkey_algorithm", key.algorithm)
+   .set("threads", static_cast<double>(threads))
+   .set("concurrency", static_cast<double>(concurrency))
+   .set("connections", static_cast<double>(total))
+   .set("failed", static_cast<double>(st.failed.load()))
+   .set("seconds", secs)
+   .set("handshakes_per_s", (total - st.failed) / secs)
+   .set("p50_ms",  bench::percentile(st.latencies, 0.5)   * 1e3)
+   .set("p99_ms",  bench::percentile(st.latencies, 0.99)  * 1e3)
+   .set("p999_ms", bench::percentile(st.latencies, 0.999) * 1e3);
+  return r;
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+  const std::size_t total       = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000u;
+  const std::size_t concurrency = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64u;
+
+  std::vector<std::size_t> thread_counts{1u, 2u, 4u};
+  const std::size_t hw = std::thread::hardware_concurrency();
+  if (hw > 4u)
+    thread_counts.push_back(hw);
+
+  bench::report report{"handshake_rate"};
+  try
+  {
+    for (auto kex : key_exchanges)
+      for (const auto & key : host_keys)
+        for (auto threads : thread_counts)
+          report.add(run(kex, key, threads, total, concurrency));
+  }
+  catch (std::exception & e)
+  {
+    std::cerr << "handshake_rate failed: " << e.what() << std::endl;
+    return 1;
+  }
+  report.print();
+  return 0;
+}
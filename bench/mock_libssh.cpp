@@ -0,0 +1,367 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "mock_libssh.hpp"
+
+#include <libssh/libssh.h>
+#include <libssh/callbacks.h>
+#include <libssh/server.h>
+
+#include <algorithm>
+#include <unistd.h>
+
+namespace
+{
+
+int script_[16];
+std::size_t script_begin = 0u, script_end = 0u;
+void (*again_hook)() = nullptr;
+std::size_t calls_ = 0u;
+
+int next(int fallback, int again)
+{
+  const int res = script_begin != script_end ? script_[script_begin++] : fallback;
+  if (res == again && again_hook)
+    again_hook();
+  return res;
+}
+
+int next(int fallback = SSH_OK)
+{
+  return next(fallback, SSH_AGAIN);
+}
+
+}
+
+struct ssh_session_struct
+{
+  socket_t fd = -1;
+};
+
+struct ssh_channel_struct
+{
+};
+
+struct ssh_bind_struct
+{
+};
+
+namespace mock
+{
+
+void script(std::initializer_list<int> results)
+{
+  script_begin = 0u;
+  script_end = (std::min)(results.size(), sizeof(script_) / sizeof(*script_));
+  std::copy_n(results.begin(), script_end, script_);
+}
+
+void reset()
+{
+  script_begin = script_end = 0u;
+}
+
+void on_again(void (*hook)())
+{
+  again_hook = hook;
+}
+
+std::size_t calls()
+{
+  return calls_;
+}
+
+}
+
+extern "C"
+{
+
+// session
+
+ssh_session ssh_new(void)
+{
+  calls_++;
+  return new ssh_session_struct;
+}
+
+void ssh_free(ssh_session session)
+{
+  calls_++;
+  // like libssh, the session owns its descriptor.
+  if (session && session->fd != -1)
+    ::close(session->fd);
+  delete session;
+}
+
+int ssh_options_set(ssh_session session, enum ssh_options_e type, const void * value)
+{
+  calls_++;
+  if (type == SSH_OPTIONS_FD)
+    session->fd = *static_cast<const socket_t*>(value);
+  return SSH_OK;
+}
+
+void ssh_set_blocking(ssh_session, int)
+{
+  calls_++;
+}
+
+const char * ssh_get_error(void *)
+{
+  calls_++;
+  return "mock error";
+}
+
+int ssh_get_error_code(void *)
+{
+  calls_++;
+  return SSH_FATAL;
+}
+
+int ssh_connect(ssh_session)
+{
+  calls_++;
+  return next();
+}
+
+void ssh_disconnect(ssh_session session)
+{
+  calls_++;
+  if (session->fd != -1)
+    ::close(session->fd);
+  session->fd = -1;
+}
+
+int ssh_set_callbacks(ssh_session, ssh_callbacks)
+{
+  calls_++;
+  return SSH_OK;
+}
+
+int ssh_set_server_callbacks(ssh_session, ssh_server_callbacks)
+{
+  calls_++;
+  return SSH_OK;
+}
+
+void ssh_set_message_callback(ssh_session, int (*)(ssh_session, ssh_message, void *), void *)
+{
+  calls_++;
+}
+
+int ssh_is_connected(ssh_session)
+{
+  calls_++;
+  return 1;
+}
+
+socket_t ssh_get_fd(ssh_session session)
+{
+  calls_++;
+  return session->fd;
+}
+
+int ssh_get_status(ssh_session)
+{
+  calls_++;
+  return 0;
+}
+
+int ssh_blocking_flush(ssh_session, int)
+{
+  calls_++;
+  return SSH_OK;
+}
+
+int ssh_userauth_none(ssh_session, const char *)
+{
+  calls_++;
+  return next(SSH_AUTH_SUCCESS, SSH_AUTH_AGAIN);
+}
+
+int ssh_userauth_publickey_auto(ssh_session, const char *, const char *)
+{
+  calls_++;
+  return next(SSH_AUTH_SUCCESS, SSH_AUTH_AGAIN);
+}
+
+int ssh_handle_key_exchange(ssh_session)
+{
+  calls_++;
+  return next();
+}
+
+// channel
+
+ssh_channel ssh_channel_new(ssh_session)
+{
+  calls_++;
+  return new ssh_channel_struct;
+}
+
+void ssh_channel_free(ssh_channel channel)
+{
+  calls_++;
+  delete channel;
+}
+
+int ssh_channel_open_session(ssh_channel)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_open_forward(ssh_channel, const char *, int, const char *, int)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_open_reverse_forward(ssh_channel, const char *, int, const char *, int)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_request_exec(ssh_channel, const char *)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_read_nonblocking(ssh_channel, void *, uint32_t count, int)
+{
+  calls_++;
+  const int res = next(static_cast<int>(count), 0);
+  return (std::min)(res, static_cast<int>(count));
+}
+
+int ssh_channel_poll(ssh_channel, int)
+{
+  calls_++;
+  return next(1 << 20, 0);
+}
+
+int ssh_channel_poll_timeout(ssh_channel, int, int)
+{
+  calls_++;
+  return next(1 << 20);
+}
+
+int ssh_channel_read(ssh_channel, void *, uint32_t count, int)
+{
+  calls_++;
+  return next(static_cast<int>(count));
+}
+
+int ssh_channel_write(ssh_channel, const void *, uint32_t len)
+{
+  calls_++;
+  return next(static_cast<int>(len));
+}
+
+int ssh_channel_write_stderr(ssh_channel, const void *, uint32_t len)
+{
+  calls_++;
+  return next(static_cast<int>(len));
+}
+
+int ssh_channel_send_eof(ssh_channel)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_close(ssh_channel)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_channel_is_eof(ssh_channel)
+{
+  calls_++;
+  return 0;
+}
+
+int ssh_channel_is_closed(ssh_channel)
+{
+  calls_++;
+  return 0;
+}
+
+uint32_t ssh_channel_window_size(ssh_channel)
+{
+  calls_++;
+  return 0x7fffffffu;
+}
+
+int ssh_channel_get_exit_status(ssh_channel)
+{
+  calls_++;
+  return 0;
+}
+
+// bind
+
+ssh_bind ssh_bind_new(void)
+{
+  calls_++;
+  return new ssh_bind_struct;
+}
+
+void ssh_bind_free(ssh_bind bind)
+{
+  calls_++;
+  delete bind;
+}
+
+int ssh_bind_options_set(ssh_bind, enum ssh_bind_options_e, const void *)
+{
+  calls_++;
+  return SSH_OK;
+}
+
+int ssh_bind_options_parse_config(ssh_bind, const char *)
+{
+  calls_++;
+  return SSH_OK;
+}
+
+int ssh_bind_listen(ssh_bind)
+{
+  calls_++;
+  return next();
+}
+
+socket_t ssh_bind_get_fd(ssh_bind)
+{
+  calls_++;
+  return -1;
+}
+
+void ssh_bind_set_blocking(ssh_bind, int)
+{
+  calls_++;
+}
+
+int ssh_bind_accept(ssh_bind, ssh_session)
+{
+  calls_++;
+  return next();
+}
+
+int ssh_bind_accept_fd(ssh_bind, ssh_session session, socket_t fd)
+{
+  calls_++;
+  const int res = next();
+  if (res == SSH_OK)
+    session->fd = fd;
+  return res;
+}
+
+}
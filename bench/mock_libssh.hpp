@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_BENCH_MOCK_LIBSSH_HPP
+#define ASIOFY_BENCH_MOCK_LIBSSH_HPP
+
+#include <cstddef>
+#include <initializer_list>
+
+// mock_libssh.cpp defines the libssh functions used by the wrappers, so linking it instead of libssh
+// leaves only the cost of asiofy itself: no crypto, no packets, no I/O.
+//
+// The session, channel & bind functions that return a status are scripted: each call takes the next value
+// of the script, once it's empty they succeed. `ssh_channel_read_nonblocking` & `ssh_channel_write`
+// return the full size by default, a scripted 0 makes the read would-block. So does a 0 for `ssh_channel_poll`,
+// which otherwise reports plenty of data.
+namespace mock
+{
+
+/// Queue the results of the next scripted calls, in order. At most 16.
+void script(std::initializer_list<int> results);
+
+/// Drop what's left of the script.
+void reset();
+
+/// Called whenever a scripted call returns SSH_AGAIN (or SSH_AUTH_AGAIN, or a read returns 0),
+/// so the caller can make the session's socket ready again.
+void on_again(void (*hook)());
+
+/// The number of mocked libssh functions called so far.
+std::size_t calls();
+
+}
+
+#endif //ASIOFY_BENCH_MOCK_LIBSSH_HPP
@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Measures what the asiofy layer costs on top of libssh, by linking against mock_libssh instead:
+// ns, allocations & libssh calls per operation. Usage: wrapper_overhead [iterations]
+//
+// The executor cases run the channel read & write hot path on sessions with different executor types,
+// to show what the type-erasure of any_io_executor costs per completion.
+//
+// asio's reactor is edge-triggered, so every wait needs a fresh event on the socket: the benchmark "pokes"
+// the socketpair (drain, then send a byte) before each wait. The `poke` case gives that cost, to subtract.
+
+#include "bench.hpp"
+#include "mock_libssh.hpp"
+
+#include <asiofy/libssh/arena.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/bind.hpp>
+#include <asiofy/libssh/buffer_pool.hpp>
+#include <asiofy/libssh/server.hpp>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+
+namespace net = boost::asio;
+
+namespace
+{
+
+std::atomic<std::size_t> allocations{0u};
+
+using bench::error_code;
+using session_type = asiofy::libssh::basic_session<net::io_context::executor_type>;
+using channel_type = asiofy::libssh::basic_channel<net::io_context::executor_type>;
+
+int session_fd = -1, peer_fd = -1;
+
+void poke()
+{
+  char buf[64];
+  while (::recv(session_fd, buf, sizeof(buf), MSG_DONTWAIT) > 0);
+  ::send(peer_fd, buf, 1, MSG_DONTWAIT);
+}
+
+bench::result describe(const char * name, std::size_t n, double secs, std::size_t allocs, std::size_t calls)
+{
+  bench::result r;
+  r.set("case", name)
+   .set("iterations", static_cast<double>(n))
+   .set("ns_per_op", secs * 1e9 / n)
+   .set("allocations_per_op", static_cast<double>(allocs) / n)
+   .set("libssh_calls_per_op", static_cast<double>(calls) / n);
+  return r;
+}
+
+// the completion handler of one iteration, which starts the next one.
+template<typename Initiate>
+struct chain
+{
+  Initiate & initiate;
+  std::size_t & left;
+
+  template<typename ... Args>
+  void operator()(Args && ...)
+  {
+    if (--left > 0u)
+      initiate(std::move(*this));
+  }
+};
+
+template<typename Initiate>
+bench::result measure_async(const char * name, net::io_context & ctx, std::size_t n, Initiate initiate)
+{
+  std::size_t left = n;
+  ctx.restart();
+  const auto allocs = allocations.load();
+  const auto calls = mock::calls();
+  const auto start = bench::clock::now();
+  initiate(chain<Initiate>{initiate, left});
+  ctx.run();
+  const auto secs = bench::seconds_since(start);
+  return describe(name, n, secs, allocations - allocs, mock::calls() - calls);
+}
+
+template<typename Func>
+bench::result measure_sync(const char * name, std::size_t n, Func func)
+{
+  const auto allocs = allocations.load();
+  const auto calls = mock::calls();
+  const auto start = bench::clock::now();
+  for (std::size_t i = 0u; i < n; i++)
+    func();
+  const auto secs = bench::seconds_since(start);
+  return describe(name, n, secs, allocations - allocs, mock::calls() - calls);
+}
+
+template<typename Executor>
+void executor_cases(bench::report & report, net::io_context & ctx, std::size_t n,
+                    const Executor & ex, const std::string & name)
+{
+  asiofy::libssh::basic_session<Executor> sess{ex};
+  asiofy::libssh::basic_channel<Executor> chan{sess};
+  char data[4096];
+
+  report.add(measure_async(("channel async_read_some, " + name).c_str(), ctx, n, [&](auto handler)
+  {
+    mock::reset();
+    chan.async_read_some(net::buffer(data), false, std::move(handler));
+  }));
+
+  report.add(measure_async(("channel async_write_some, " + name).c_str(), ctx, n, [&](auto handler)
+  {
+    mock::reset();
+    chan.async_write_some(net::buffer(data), false, std::move(handler));
+  }));
+}
+
+}
+
+void * operator new(std::size_t size)
+{
+  allocations++;
+  if (void * p = std::malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+int main(int argc, char * argv[])
+{
+  const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000u;
+
+  net::io_context ctx;
+  session_type sess{ctx.get_executor()};
+  {
+    net::local::stream_protocol::socket a{ctx}, b{ctx};
+    net::local::connect_pair(a, b);
+    session_fd = a.release();
+    peer_fd = b.release();
+  }
+  sess.next_layer().assign(net::generic::stream_protocol(net::local::stream_protocol()), session_fd);
+  mock::on_again(&poke);
+
+  channel_type chan{sess};
+  char data[4096];
+  asiofy::libssh::error_info ei;
+  asiofy::libssh::basic_bind<net::io_context::executor_type> bind{ctx.get_executor()};
+
+  bench::report report{"wrapper_overhead"};
+
+  report.add(measure_sync("poke", n, []{ poke(); }));
+
+  report.add(measure_sync("connect (sync)", n, [&]
+  {
+    mock::script({SSH_OK});
+    error_code ec;
+    sess.connect(ec, ei);
+  }));
+
+  report.add(measure_async("async_connect", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_OK});
+    sess.async_connect(std::move(handler));
+  }));
+
+  report.add(measure_async("async_connect, 2x SSH_AGAIN", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_AGAIN, SSH_AGAIN, SSH_OK});
+    sess.async_connect(std::move(handler));
+  }));
+
+  report.add(measure_async("async_connect, SSH_ERROR", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_ERROR});
+    sess.async_connect(ei, std::move(handler));
+  }));
+
+  report.add(measure_async("async_handle_key_exchange", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_OK});
+    asiofy::libssh::async_handle_key_exchange(sess, std::move(handler));
+  }));
+
+  report.add(measure_async("async_userauth_publickey_auto", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_AUTH_SUCCESS});
+    sess.async_userauth_publickey_auto(nullptr, nullptr, std::move(handler));
+  }));
+
+  report.add(measure_async("channel async_read_some", ctx, n, [&](auto handler)
+  {
+    mock::reset();
+    chan.async_read_some(net::buffer(data), false, std::move(handler));
+  }));
+
+  report.add(measure_async("channel async_read_some, would block", ctx, n, [&](auto handler)
+  {
+    mock::script({0, static_cast<int>(sizeof(data))});
+    chan.async_read_some(net::buffer(data), false, std::move(handler));
+  }));
+
+#if defined(ASIOFY_HAS_PMR)
+  {
+    // the same, but the waits allocate from the session's arena.
+    session_type arena_sess{ctx.get_executor()};
+    arena_sess.set_memory_resource(std::make_unique<asiofy::libssh::session_arena>());
+    arena_sess.next_layer().assign(net::generic::stream_protocol(net::local::stream_protocol()), ::dup(session_fd));
+    channel_type arena_chan{arena_sess};
+    report.add(measure_async("channel async_read_some, would block, session_arena", ctx, n, [&](auto handler)
+    {
+      mock::script({0, static_cast<int>(sizeof(data))});
+      arena_chan.async_read_some(net::buffer(data), false, std::move(handler));
+    }));
+  }
+#endif
+
+  {
+    // the buffer is only taken once the poll reports data, & given back before the next read.
+    asiofy::libssh::buffer_pool pool{sizeof(data), 1u};
+    report.add(measure_async("channel async_read_some, buffer_pool", ctx, n, [&](auto handler)
+    {
+      mock::reset();
+      chan.async_read_some(pool, false, std::move(handler));
+    }));
+
+    report.add(measure_async("channel async_read_some, would block, buffer_pool", ctx, n, [&](auto handler)
+    {
+      mock::script({0});
+      chan.async_read_some(pool, false, std::move(handler));
+    }));
+  }
+
+  report.add(measure_async("channel async_write_some", ctx, n, [&](auto handler)
+  {
+    mock::reset();
+    chan.async_write_some(net::buffer(data), false, std::move(handler));
+  }));
+
+  report.add(measure_async("channel async_send_eof", ctx, n, [&](auto handler)
+  {
+    poke();
+    mock::script({SSH_OK});
+    chan.async_send_eof(std::move(handler));
+  }));
+
+  executor_cases(report, ctx, n, net::any_io_executor(ctx.get_executor()), "any_io_executor");
+  executor_cases(report, ctx, n, ctx.get_executor(), "io_context::executor_type");
+  executor_cases(report, ctx, n, net::make_strand(ctx), "strand");
+
+  report.add(measure_sync("bind accept_fd", n, [&]
+  {
+    mock::script({SSH_OK});
+    session_type accepted{ctx.get_executor()};
+    error_code ec;
+    bind.accept_fd(accepted, ::dup(peer_fd), ec, ei);
+  }));
+
+  asiofy::libssh::session_handle_pool pool;
+  report.add(measure_sync("bind accept_fd, pooled session", n, [&]
+  {
+    mock::script({SSH_OK});
+    session_type accepted{ctx.get_executor(), pool.acquire()};
+    error_code ec;
+    bind.accept_fd(accepted, ::dup(peer_fd), ec, ei);
+  }));
+
+  report.print();
+  return 0;
+}
@@ -8,24 +8,70 @@
 #ifndef ASIOFY_CONFIG_HPP
 #define ASIOFY_CONFIG_HPP
 
+// ASIOFY_STANDALONE uses standalone asio & std::error_code instead of Boost.Asio & Boost.System.
+// It needs C++17 for std::optional.
 #if defined(ASIOFY_STANDALONE)
 namespace asio {}
+#include <asio/async_result.hpp>
+#include <optional>
 #include <system_error>
 #else
 namespace boost { namespace asio {} }
+#include <boost/asio/async_result.hpp>
+#include <boost/optional.hpp>
 #include <boost/system/system_error.hpp>
+#include <boost/throw_exception.hpp>
+#endif
+
+// ASIOFY_HEADER_ONLY includes the compiled sources with the headers,
+// otherwise one TU needs to include asiofy/libssh/src.hpp or link the asiofy_libssh library.
+#if defined(ASIOFY_HEADER_ONLY)
+#define ASIOFY_DECL inline
+#else
+#define ASIOFY_DECL
+#endif
+
+// ASIOFY_HAS_PMR is defined if std::pmr is available, which is needed for session arenas.
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#define ASIOFY_HAS_PMR 1
+#endif
+#endif
+
+#if defined(ASIOFY_STANDALONE)
+#define ASIOFY_COMPLETION_TOKEN_FOR(...)          ASIO_COMPLETION_TOKEN_FOR(__VA_ARGS__)
+#define ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(...) ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(__VA_ARGS__)
+#define ASIOFY_INITFN_RESULT_TYPE(...)            ASIO_INITFN_RESULT_TYPE(__VA_ARGS__)
+#define ASIOFY_DEFAULT_COMPLETION_TOKEN(...)      ASIO_DEFAULT_COMPLETION_TOKEN(__VA_ARGS__)
+#define ASIOFY_CORO_REENTER(...)                  ASIO_CORO_REENTER(__VA_ARGS__)
+#define ASIOFY_CORO_YIELD                         ASIO_CORO_YIELD
+#if defined(ASIO_WINDOWS)
+#define ASIOFY_WINDOWS 1
+#endif
+#else
+#define ASIOFY_COMPLETION_TOKEN_FOR(...)          BOOST_ASIO_COMPLETION_TOKEN_FOR(__VA_ARGS__)
+#define ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(...) BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(__VA_ARGS__)
+#define ASIOFY_INITFN_RESULT_TYPE(...)            BOOST_ASIO_INITFN_RESULT_TYPE(__VA_ARGS__)
+#define ASIOFY_DEFAULT_COMPLETION_TOKEN(...)      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(__VA_ARGS__)
+#define ASIOFY_CORO_REENTER(...)                  BOOST_ASIO_CORO_REENTER(__VA_ARGS__)
+#define ASIOFY_CORO_YIELD                         BOOST_ASIO_CORO_YIELD
+#if defined(BOOST_ASIO_WINDOWS)
+#define ASIOFY_WINDOWS 1
+#endif
 #endif
 
 namespace asiofy
 {
 
 #if defined(ASIOFY_STANDALONE)
+namespace net = asio;
 using std::error_code;
 using std::system_error;
 using std::error_category;
-using std::system_error;
+using std::generic_category;
+template<typename T>
+using optional = std::optional<T>;
 
-namespace net = asio;
 #define ASIOFY_ASSIGN_EC(Name, ...) Name.assign(__VA_ARGS__);
 
 template <typename Exception>
@@ -34,21 +80,21 @@ inline void throw_exception(const Exception& e)
   throw e;
 }
 
-
 #else
 namespace net = boost::asio;
 using boost::system::error_code;
 using boost::system::system_error;
 using boost::system::error_category;
-using boost::system::system_error;
+using boost::system::generic_category;
 using boost::throw_exception;
+template<typename T>
+using optional = boost::optional<T>;
 
 #define ASIOFY_ASSIGN_EC(Name, ...) \
   {                                 \
     constexpr static boost::source_location loc = BOOST_CURRENT_LOCATION; \
     Name.assign(__VA_ARGS__, &loc); \
   }
-using boost::throw_exception;
 
 #endif
 
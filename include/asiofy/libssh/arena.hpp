@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_ARENA_HPP
+#define ASIOFY_LIBSSH_ARENA_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+
+#if defined(ASIOFY_HAS_PMR)
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// A memory resource for the operations of a single session.
+/** It gets the waits on the session's socket, which hold the state of the session's operations,
+ * and the buffers & states the session allocates through `get_allocator`.
+ * Waits on other I/O objects, e.g. the timers & acceptors of the forwarders, and the
+ * completion of the final handler use the allocator associated with the handler;
+ * `error_info` messages use the default heap.
+ *
+ * Memory given back gets reused through the pools of `PoolResource`, which take their chunks
+ * from a monotonic buffer. Nothing is returned to the upstream resource before the arena is destroyed
+ * or `release`d, which hands back all chunks at once. They grow geometrically,
+ * so that's a handful of deallocations no matter how many operations the session ran.
+ *
+ * Install it with `basic_session::set_memory_resource` before starting any operation.
+ */
+template<typename PoolResource>
+class basic_session_arena final : public std::pmr::memory_resource
+{
+ public:
+  /// @param initial_size The size of the first chunk taken from `upstream`.
+  explicit basic_session_arena(std::size_t initial_size = 4096u,
+                               std::pmr::memory_resource * upstream = std::pmr::new_delete_resource())
+      : monotonic_(initial_size, upstream), pool_(&monotonic_)
+  {
+  }
+
+  basic_session_arena(const basic_session_arena &) = delete;
+  basic_session_arena& operator=(const basic_session_arena &) = delete;
+
+  /// Free all memory at once, all of it must have been deallocated or abandoned.
+  void release()
+  {
+    pool_.release();
+    monotonic_.release();
+  }
+
+ private:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    return pool_.allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+  {
+    pool_.deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+
+  std::pmr::monotonic_buffer_resource monotonic_;
+  PoolResource pool_;
+};
+
+/// An arena for a session of an io_context that is run by a single thread.
+using session_arena = basic_session_arena<std::pmr::unsynchronized_pool_resource>;
+
+/// An arena for a session on a strand of an io_context run by several threads.
+/** asio frees the memory of a completed wait before it dispatches to the strand,
+ * so the arena can be used by two threads at once. */
+using concurrent_session_arena = basic_session_arena<std::pmr::synchronized_pool_resource>;
+
+}
+}
+
+#endif
+
+#endif //ASIOFY_LIBSSH_ARENA_HPP
@@ -8,8 +8,18 @@
 #ifndef ASIOFY_BASIC_CHANNEL_HPP
 #define ASIOFY_BASIC_CHANNEL_HPP
 
+#if defined(ASIOFY_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#else
 #include <boost/asio/any_io_executor.hpp>
+#endif
 #include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/handles.hpp>
+#include <asiofy/libssh/detail/wrapper.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/buffer_pool.hpp>
+
+#include <vector>
 
 namespace asiofy
 {
@@ -22,24 +32,99 @@ struct basic_channel
   /// The type of the executor associated with the object.
   typedef Executor executor_type;
 
+  /// Rebinds the channel type to another executor.
+  template <typename Executor1>
+  struct rebind_executor
+  {
+    /// The channel type when rebound to the specified executor.
+    typedef basic_channel<Executor1> other;
+  };
+
+  /// The native representation of a channel.
+  typedef ssh_channel native_handle_type;
+
+  /// The session type the channel runs on.
+  typedef basic_session<executor_type> session_type;
+
+  explicit basic_channel(session_type & session)
+      : session_(&session), handle_(ssh_channel_new(session.native_handle()))
+  {
+  }
+
+  basic_channel(session_type & session, const native_handle_type& native_handle)
+      : session_(&session), handle_(native_handle)
+  {
+  }
+
+  basic_channel(basic_channel&& other) = default;
+  basic_channel& operator=(basic_channel&& other) = default;
+
+  executor_type get_executor() noexcept
+  {
+    return session_->get_executor();
+  }
+
+  session_type & session() { return *session_; }
+
+  native_handle_type release()
+  {
+    return handle_.release();
+  }
+
+  native_handle_type native_handle()
+  {
+    return handle_.get();
+  }
+
+  /// An id of the channel, unique in the process.
+  std::uint64_t id() const { return id_; }
+
+  /// The traffic of this channel, it's also added to the session's.
+        traffic_stats & traffic()       { return traffic_; }
+  const traffic_stats & traffic() const { return traffic_; }
+
   void open_session();
   void open_session(error_code & ec, error_info & ei);
   template<
-    BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-        BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+    ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+      ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+        ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_open_session(
-      RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
 
   void open_x11(const char * orig_addr, int orig_port);
   void open_x11(const char * orig_addr, int orig_port, error_code & ec, error_info & ei);
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
     async_open_x11(const char * orig_addr, int orig_port,
-        RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+        RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+
+  /// Open a direct-tcpip channel, i.e. let the server connect to `remote_host:remote_port`.
+  void open_forward(const char * remote_host, int remote_port, const char * source_host, int local_port);
+  void open_forward(const char * remote_host, int remote_port, const char * source_host, int local_port,
+                    error_code & ec, error_info & ei);
+  template<
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+    async_open_forward(const char * remote_host, int remote_port, const char * source_host, int local_port,
+        RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+
+  /// Open a forwarded-tcpip channel on a server session, for a connection to a port the client requested.
+  void open_reverse_forward(const char * remote_host, int remote_port, const char * source_host, int local_port);
+  void open_reverse_forward(const char * remote_host, int remote_port, const char * source_host, int local_port,
+                            error_code & ec, error_info & ei);
+  template<
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+    async_open_reverse_forward(const char * remote_host, int remote_port, const char * source_host, int local_port,
+        RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
 
   void poll(bool is_stderr);
@@ -52,12 +137,25 @@ struct basic_channel
   std::size_t read_some(const MutableBufferSequence & buffers, bool istderr, error_code & ec);
 
   template<typename MutableBufferSequence,
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
   async_read_some(
       const MutableBufferSequence & buffers, bool istderr,
-      ReadToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ReadToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+  /// Read into a buffer taken from `pool` only once data is available, so an idle reader holds no memory.
+  /** The result is empty on error, otherwise it holds at most `pool.buffer_size()` bytes. */
+  pooled_buffer read_some(buffer_pool & pool, bool istderr);
+  pooled_buffer read_some(buffer_pool & pool, bool istderr, error_code & ec);
+
+  template<
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, pooled_buffer)) ReadToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, pooled_buffer))
+  async_read_some(
+      buffer_pool & pool, bool istderr,
+      ReadToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
   template<typename ConstBufferSequence>
   std::size_t write_some(const ConstBufferSequence & buffers, bool istderr);
@@ -66,15 +164,18 @@ struct basic_channel
   std::size_t write_some(const ConstBufferSequence & buffers, bool istderr, error_code & ec);
 
   template<typename ConstBufferSequence,
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
   async_write_some(
       const ConstBufferSequence & buffers, bool istderr,
-      ReadToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ReadToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
   struct stdreader
   {
+    typedef typename basic_channel::executor_type executor_type;
+    executor_type get_executor() { return self->get_executor(); }
+
     template<typename MutableBufferSequence>
     std::size_t read_some(const MutableBufferSequence & buffers)
     {
@@ -88,12 +189,12 @@ struct basic_channel
     }
 
     template<typename MutableBufferSequence,
-        BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
-          BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-            BOOST_ASIO_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
+        ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken
+          ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+            ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
     async_read_some(
         const MutableBufferSequence & buffers,
-        ReadToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+        ReadToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
     {
       return self->async_read_some(buffers, istderr, std::forward<ReadToken>(token));
     }
@@ -111,12 +212,12 @@ struct basic_channel
     }
   
     template<typename ConstBufferSequence,
-        BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) WriteToken
-          BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-            BOOST_ASIO_INITFN_RESULT_TYPE(WriteToken, void (error_code, std::size_t))
+        ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) WriteToken
+          ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+            ASIOFY_INITFN_RESULT_TYPE(WriteToken, void (error_code, std::size_t))
     async_write_some(
         const ConstBufferSequence & buffers,
-        WriteToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+        WriteToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
     {
       return self->async_write_some(buffers, istderr, std::forward<WriteToken>(token));
 
@@ -124,6 +225,7 @@ struct basic_channel
 
     friend struct basic_channel;
    private:
+    stdreader(basic_channel * self, bool istderr) : self(self), istderr(istderr) {}
     basic_channel * self;
     bool istderr;
   };
@@ -135,155 +237,317 @@ struct basic_channel
   void request_auth_agent();
   void request_auth_agent(error_code & ec, error_info & ei);
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
-  async_request_auth_agent(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+  async_request_auth_agent(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
 
   void request_env(const char * name, const char * value);
   void request_env(const char * name, const char * value, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_env(const char * name, const char * value,
-                    RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                    RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_exec(const char * cmd);
   void request_exec(const char * cmd, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_exec(const char * cmd,
-                    RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                    RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_pty();
   void request_pty(error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
-  async_request_pty(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+  async_request_pty(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_pty_size(const char * terminal, int col, int row);
   void request_pty_size(const char * terminal, int col, int row, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_pty_size(const char * terminal, int col, int row,
-                         RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                         RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_send_break(std::uint32_t length);
   void request_send_break(std::uint32_t length, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_send_break(std::uint32_t length,
-                           RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                           RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
   void request_send_exit_signal(const char *sig, int core, const char * errmsg, const char * lang);
   void request_send_exit_signal(const char *sig, int core, const char * errmsg, const char * lang, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_send_exit_signal(const char *sig, int core, const char * errmsg, const char * lang,
-                                 RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                                 RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
   void request_send_exit_status(int exit_status);
   void request_send_exit_status(int exit_status, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_send_exit_status(int exit_status,
-                                 RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                                 RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
     
   void request_send_signal(const char *sig);
   void request_send_signal(const char *sig, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_send_signal(const char *sig,
-                            RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                            RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
 
   void request_sftp();
   void request_sftp(error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
-  async_request_sftp(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+  async_request_sftp(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_shell();
   void request_shell(error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
-  async_request_shell(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+  async_request_shell(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void request_subsystem(const char * subsys);
   void request_subsystem(const char * subsys, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_subsystem(const char * subsys,
-                          RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                          RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
   
   void request_x11(int single_connection, const char * protocol, const char * cookie, int screen_number);
   void request_x11(int single_connection, const char * protocol, const char * cookie, int screen_number, error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
   async_request_x11(int single_connection, const char * protocol, const char * cookie, int screen_number,
-                    RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+                    RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
   void send_eof();
   void send_eof(error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code))
-  async_send_eof(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+  async_send_eof(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+  /// The exit status sent by the remote command, -1 if the channel closed without it.
+  int exit_status();
+  int exit_status(error_code & ec, error_info & ei);
+
+  template<
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, int)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code, int))
+  async_exit_status(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
+
+  bool is_open() const { return handle_ && ssh_channel_is_open(handle_.get()) != 0; }
+  bool is_eof()  const { return handle_ && ssh_channel_is_eof(handle_.get()) != 0; }
+
+  void close();
+  void close(error_code & ec, error_info & ei);
 
   std::uint32_t window_size();
   std::uint32_t window_size(error_code & ec, error_info & ei);
 
   template<
-      BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, std::uint32_t)) RequestToken
-        BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-          BOOST_ASIO_INITFN_RESULT_TYPE(RequestToken, void (error_code, std::uint32_t))
-  async_window_size(RequestToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type));
+      ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::uint32_t)) RequestToken
+        ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+          ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code, std::uint32_t))
+  async_window_size(RequestToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type));
 
 
  private:
+  session_type * session_;
   detail::unique_handle<ssh_channel, ssh_channel_free> handle_{};
+  std::uint64_t id_ = detail::next_id();
+  traffic_stats traffic_;
 
 };
 
+namespace detail
+{
+
+// Sends all the open requests at once and then checks every pending channel when data came in,
+// since one ssh_channel_open_session call processes the confirmations for all channels.
+template<typename Executor, typename OpenHandler>
+struct async_open_sessions_op
+{
+  basic_session<Executor> & sess;
+  std::size_t n;
+  OpenHandler on_open;
+  error_info * ei;
+  std::vector<basic_channel<Executor>> pending = {};
+  std::size_t opened = 0u;
+  error_code first_error = {};
+  op_instrument<op_kind::channel_open> instrument = {};
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    instrument.initiated(sess);
+    ssh_set_blocking(sess.native_handle(), 0);
+    pending.reserve(n);
+    for (std::size_t i = 0u; i < n; i++)
+      pending.emplace_back(sess);
+    instrument.waiting(sess, net::socket_base::wait_write);
+    detail::async_wait(sess, net::socket_base::wait_write, std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    instrument.woken(sess);
+    if (ec)
+      return instrument.complete(sess, self, ec, opened);
+
+    for (std::size_t i = 0u; i < pending.size(); )
+    {
+      auto & chan = pending[i];
+      // ssh_channel_new fails e.g. on a session that isn't authenticated.
+      const int rc = chan.native_handle() == nullptr
+          ? SSH_ERROR
+          : instrument.call(sess, [&]{ return ssh_channel_open_session(chan.native_handle()); });
+      switch (rc)
+      {
+        case SSH_AGAIN:
+          i++;
+          continue;
+        case SSH_OK:
+          opened++;
+          on_open(error_code{}, std::move(chan));
+          break;
+        case SSH_ERROR:
+        default:
+        {
+          error_code oec;
+          ASIOFY_ASSIGN_EC(oec, ssh_get_error_code(sess.native_handle()), ssh_category());
+          // ssh_channel_new doesn't always set an error on the session.
+          if (!oec)
+            ASIOFY_ASSIGN_EC(oec, net::error::not_connected, net::error::get_system_category());
+          if (!first_error)
+          {
+            first_error = oec;
+            if (ei)
+              ei->set_message(ssh_get_error(sess.native_handle()));
+          }
+          on_open(oec, std::move(chan));
+        }
+      }
+      // order doesn't matter, so we don't need to shift the rest.
+      if (i + 1u != pending.size())
+        chan = std::move(pending.back());
+      pending.pop_back();
+    }
+
+    if (pending.empty())
+      return instrument.complete(sess, self, first_error, opened);
+    instrument.retried(sess);
+    instrument.waiting(sess, net::socket_base::wait_read);
+    detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+  }
+};
+
+}
+
+/// Open `n` session channels concurrently.
+/** `on_open` gets invoked with `void(error_code, basic_channel<Executor>)` as soon as each channel is open,
+ * the token completes with the first error and the number of successfully opened channels once all are done. */
+template<typename Executor, typename OpenHandler,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) OpenToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(OpenToken, void (error_code, std::size_t))
+async_open_sessions(basic_session<Executor> & sess, std::size_t n, OpenHandler && on_open,
+                    OpenToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<OpenToken, void (error_code, std::size_t)>
+      (
+          detail::async_open_sessions_op<Executor, typename std::decay<OpenHandler>::type>{
+              sess, n, std::forward<OpenHandler>(on_open), nullptr, {}, 0u, {}, {}},
+          token, sess.next_layer()
+      );
+}
+
+template<typename Executor, typename OpenHandler,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) OpenToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(OpenToken, void (error_code, std::size_t))
+async_open_sessions(basic_session<Executor> & sess, std::size_t n, OpenHandler && on_open,
+                    error_info & ei,
+                    OpenToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<OpenToken, void (error_code, std::size_t)>
+      (
+          detail::async_open_sessions_op<Executor, typename std::decay<OpenHandler>::type>{
+              sess, n, std::forward<OpenHandler>(on_open), &ei, {}, 0u, {}, {}},
+          token, sess.next_layer()
+      );
+}
+
+}
+}
+
+#include <asiofy/libssh/impl/basic_channel.hpp>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// A channel of an io_session.
+using io_channel = basic_channel<net::io_context::executor_type>;
+/// A channel of a strand_session.
+using strand_channel = basic_channel<net::strand<net::io_context::executor_type>>;
+
+#define ASIOFY_LIBSSH_INSTANTIATE_CHANNEL(Extern, Executor)                                                          \
+  Extern template struct basic_channel<Executor>;                                                                    \
+  Extern template std::size_t basic_channel<Executor>::read_some(const net::mutable_buffer &, bool, error_code &);  \
+  Extern template std::size_t basic_channel<Executor>::write_some(const net::const_buffer &, bool, error_code &);
+
+#if defined(ASIOFY_SEPARATE_COMPILATION)
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_CHANNEL, extern)
+#endif
+
 }
 }
 
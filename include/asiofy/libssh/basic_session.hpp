@@ -0,0 +1,361 @@
+//
+// Copyright (c) 2022 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_BASIC_SESSION_HPP
+#define ASIOFY_LIBSSH_BASIC_SESSION_HPP
+
+#include <libssh/libssh.h>
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/handles.hpp>
+#include <asiofy/libssh/detail/memory.hpp>
+#include <asiofy/libssh/detail/wrapper.hpp>
+#include <asiofy/libssh/error.hpp>
+#include <asiofy/libssh/handle_pool.hpp>
+#include <asiofy/libssh/socket.hpp>
+#include <asiofy/libssh/stats.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/io_context.hpp>
+#include <asio/strand.hpp>
+#include <asio/generic/stream_protocol.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#endif
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// A libssh session, that uses the io-object `next_layer()` to wait for the socket that libssh operates on.
+/** The session is not thread-safe, just like libssh itself,
+ * so use a strand if the executor is shared between threads. */
+template<typename Executor = net::any_io_executor>
+struct basic_session
+{
+  /// The type of the executor associated with the object.
+  typedef Executor executor_type;
+
+  /// Rebinds the session type to another executor.
+  template <typename Executor1>
+  struct rebind_executor
+  {
+    /// The session type when rebound to the specified executor.
+    typedef basic_session<Executor1> other;
+  };
+
+  /// The native representation of a session.
+  typedef ssh_session native_handle_type;
+  /// The socket libssh operates on. Once libssh is given the descriptor, the socket only releases it.
+  using next_layer_type = wait_socket<net::generic::stream_protocol, executor_type>;
+        next_layer_type & next_layer()       { return socket_; }
+  const next_layer_type & next_layer() const { return socket_; }
+
+  explicit basic_session(const executor_type& ex)
+      : socket_(ex)
+  {
+  }
+
+  template <typename ExecutionContext>
+  explicit basic_session(ExecutionContext& context,
+                         typename std::enable_if<
+                             std::is_convertible<ExecutionContext&, net::execution_context&>::value,
+                             int>::type = 0)
+      : socket_(context)
+  {
+  }
+
+  basic_session(const executor_type& ex,
+                const native_handle_type& native_handle)
+      : socket_(ex), handle_(native_handle)
+  {
+  }
+
+  template <typename ExecutionContext>
+  basic_session(ExecutionContext& context,
+                const native_handle_type& native_handle,
+                typename std::enable_if<
+                    std::is_convertible<ExecutionContext&, net::execution_context&>::value,
+                    int >::type = 0) : socket_(context), handle_(native_handle)
+  {
+  }
+
+  /// Use a handle taken from a `session_handle_pool`, which it gets returned to when the session is destroyed.
+  basic_session(const executor_type& ex, session_handle handle)
+      : socket_(ex), handle_(std::move(handle))
+  {
+  }
+
+  template <typename ExecutionContext>
+  basic_session(ExecutionContext& context,
+                session_handle handle,
+                typename std::enable_if<
+                    std::is_convertible<ExecutionContext&, net::execution_context&>::value,
+                    int >::type = 0) : socket_(context), handle_(std::move(handle))
+  {
+  }
+
+  basic_session(basic_session&& other) = default;
+  // the members get assigned in order, so the socket is dropped before the old handle closes its fd.
+  basic_session& operator=(basic_session&& other) = default;
+
+  ~basic_session()
+  {
+    // deregister the fd from the reactor before ssh_free closes it, it might get reused by then.
+    error_code ec;
+    socket_.drop(ec);
+  }
+
+  // All sessions have access to each other's implementations.
+  template <typename Executor1>
+  friend struct basic_session;
+
+  template <typename Executor1>
+  basic_session(basic_session<Executor1>&& other,
+                typename std::enable_if<
+                    std::is_convertible<Executor1, Executor>::value, int>::type = 0)
+      :
+#if defined(ASIOFY_HAS_PMR)
+        memory_resource_(std::move(other.memory_resource_)),
+#endif
+        socket_(std::move(other.socket_)), handle_(std::move(other.handle_)),
+        id_(other.id_), traffic_(other.traffic_)
+  {
+#if defined(ASIOFY_LIBSSH_ENABLE_STATS)
+    stats_ = other.stats_;
+#endif
+  }
+
+  executor_type get_executor() noexcept
+  {
+    return socket_.get_executor();
+  }
+
+  void assign(native_handle_type native_handle)
+  {
+    handle_.reset(native_handle);
+  }
+
+  native_handle_type release()
+  {
+    return handle_.release();
+  }
+
+  native_handle_type native_handle()
+  {
+    return handle_.get();
+  }
+
+  bool options_set(enum ssh_options_e type, const char *value)
+  {
+    return ssh_options_set(handle_.get(), type, value) == SSH_OK;
+  }
+  bool options_set(enum ssh_options_e type, long value)
+  {
+    return ssh_options_set(handle_.get(), type, &value) == SSH_OK;
+  }
+  bool options_set(enum ssh_options_e type, int value)
+  {
+    return ssh_options_set(handle_.get(), type, &value) == SSH_OK;
+  }
+  bool options_set(enum ssh_options_e type, unsigned int value)
+  {
+    return ssh_options_set(handle_.get(), type, &value) == SSH_OK;
+  }
+
+  /// An id of the session, unique in the process.
+  std::uint64_t id() const { return id_; }
+
+  /// The traffic of all the channels on this session.
+        traffic_stats & traffic()       { return traffic_; }
+  const traffic_stats & traffic() const { return traffic_; }
+
+  /// The allocator for the memory of this session, i.e. the waits on its socket & the state of its operations.
+  using allocator_type = detail::session_allocator;
+
+#if defined(ASIOFY_HAS_PMR)
+  /// Allocate the operations of this session from `resource`, e.g. a `session_arena`, which the session takes over.
+  /** That's what is allocated through `get_allocator`, the waits on the session's socket included.
+   * Waits on other I/O objects & the completion of the final handler use the handler's allocator.
+   * Must be called before an operation is started or a channel is opened, since they free into the resource. */
+  void set_memory_resource(std::unique_ptr<std::pmr::memory_resource> resource)
+  {
+    memory_resource_ = std::move(resource);
+  }
+
+  /// The memory resource of this session, or null if it uses the default resource.
+  std::pmr::memory_resource * memory_resource() const { return memory_resource_.get(); }
+
+  allocator_type get_allocator() const
+  {
+    return allocator_type(memory_resource_ ? memory_resource_.get() : std::pmr::get_default_resource());
+  }
+#else
+  allocator_type get_allocator() const { return allocator_type(); }
+#endif
+
+#if defined(ASIOFY_LIBSSH_ENABLE_STATS)
+  /// What the async operations on this session cost, per kind of operation.
+        session_stats & stats()       { return stats_; }
+  const session_stats & stats() const { return stats_; }
+#endif
+
+  bool is_connected()
+  {
+    return handle_ && ssh_is_connected(handle_.get()) != 0;
+  }
+
+  void disconnect()
+  {
+    // ssh_disconnect closes the fd if libssh got it, so it must leave the reactor first.
+    // if it didn't, e.g. because the tcp connect failed, the socket closes it itself.
+    error_code ec;
+    socket_.drop(ec);
+    if (handle_)
+      ssh_disconnect(handle_.get());
+  }
+
+  /// Connect & perform the key exchange. If next_layer() is open, libssh will use it.
+  void connect()
+  {
+    use_next_layer();
+    ssh_set_blocking(handle_.get(), 1);
+    if (ssh_connect(handle_.get()) != SSH_OK)
+      ASIOFY_LIBSSH_THROW_ERROR(handle_.get())
+  }
+
+  void connect(error_code & ec, error_info & ei)
+  {
+    use_next_layer();
+    ssh_set_blocking(handle_.get(), 1);
+    if (ssh_connect(handle_.get()) != SSH_OK)
+      ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get())
+  }
+
+  /// Perform the key exchange asynchronously, next_layer() must already be connected.
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+  async_connect(ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    use_next_layer();
+    return detail::async_session_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::connect>(
+        *this, &ssh_connect, nullptr, std::forward<ConnectToken>(token));
+  }
+
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+  async_connect(error_info & ei, ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    use_next_layer();
+    return detail::async_session_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::connect>(
+        *this, &ssh_connect, &ei, std::forward<ConnectToken>(token));
+  }
+
+  void userauth_publickey_auto(const char * username, const char * passphrase = nullptr)
+  {
+    error_code ec;
+    error_info ei;
+    userauth_publickey_auto(username, passphrase, ec, ei);
+    if (ec)
+      throw_exception(system_error(ec, ei.message()));
+  }
+
+  void userauth_publickey_auto(const char * username, const char * passphrase, error_code & ec, error_info & ei)
+  {
+    ssh_set_blocking(handle_.get(), 1);
+    switch (ssh_userauth_publickey_auto(handle_.get(), username, passphrase))
+    {
+      case SSH_AUTH_SUCCESS:
+        break;
+      case SSH_AUTH_DENIED:
+        ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::auth_denied), asiofy_category());
+        break;
+      case SSH_AUTH_PARTIAL:
+        ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::auth_partial), asiofy_category());
+        break;
+      default:
+        ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get())
+    }
+  }
+
+  /// Authenticate with the keys from the agent or the default identities.
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) AuthToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AuthToken, void (error_code))
+  async_userauth_publickey_auto(const char * username, const char * passphrase,
+                                AuthToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return detail::async_auth_op(
+        *this,
+        [username, passphrase](ssh_session sess)
+        {
+          return ssh_userauth_publickey_auto(sess, username, passphrase);
+        },
+        nullptr, std::forward<AuthToken>(token));
+  }
+
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) AuthToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AuthToken, void (error_code))
+  async_userauth_publickey_auto(const char * username, const char * passphrase, error_info & ei,
+                                AuthToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return detail::async_auth_op(
+        *this,
+        [username, passphrase](ssh_session sess)
+        {
+          return ssh_userauth_publickey_auto(sess, username, passphrase);
+        },
+        &ei, std::forward<AuthToken>(token));
+  }
+
+ private:
+  void use_next_layer()
+  {
+    if (socket_.is_open())
+    {
+      socket_t fd = socket_.native_handle();
+      if (ssh_options_set(handle_.get(), SSH_OPTIONS_FD, &fd) == SSH_OK)
+        socket_.disown();
+    }
+  }
+
+#if defined(ASIOFY_HAS_PMR)
+  // declared first, so it outlives everything that might have allocated from it.
+  std::unique_ptr<std::pmr::memory_resource> memory_resource_;
+#endif
+  next_layer_type socket_;
+  session_handle handle_{ssh_new()};
+  std::uint64_t id_ = detail::next_id();
+  traffic_stats traffic_;
+#if defined(ASIOFY_LIBSSH_ENABLE_STATS)
+  session_stats stats_;
+#endif
+};
+
+/// A session using the executor of an io_context directly, which avoids the type-erasure of any_io_executor.
+using io_session = basic_session<net::io_context::executor_type>;
+/// A session on a strand of an io_context, for an io_context run by several threads.
+using strand_session = basic_session<net::strand<net::io_context::executor_type>>;
+
+#define ASIOFY_LIBSSH_INSTANTIATE_SESSION(Extern, Executor)                                                          \
+  Extern template struct basic_session<Executor>;
+
+#if defined(ASIOFY_SEPARATE_COMPILATION)
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_SESSION, extern)
+#endif
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_BASIC_SESSION_HPP
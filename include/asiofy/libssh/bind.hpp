@@ -11,48 +11,40 @@
 #include <libssh/server.h>
 #include <asiofy/libssh/detail/config.hpp>
 #include <asiofy/libssh/detail/handles.hpp>
+#include <asiofy/libssh/detail/trace.hpp>
+#include <asiofy/libssh/options.hpp>
 #include "error.hpp"
 #include "basic_session.hpp"
 
+#if defined(ASIOFY_STANDALONE)
+#include <asio/basic_socket_acceptor.hpp>
+#else
 #include <boost/asio/basic_socket_acceptor.hpp>
+#endif
 
 namespace asiofy
 {
 namespace libssh
 {
 
-// helpers to make this type-safe
-
+/// A type-safe option of a bind, see `ssh_bind_options_set`.
 template<ssh_bind_options_e Option, typename T>
-struct bind_option
+struct bind_option : detail::basic_option<ssh_bind_options_e, Option, T>
 {
-  constexpr static ssh_bind_options_e option = Option;
-  using value_type = T;
-  value_type value = {};
-  bind_option() = default;
-  explicit bind_option(value_type value) : value(value) {}
-
-  bool apply(ssh_bind bind) const
-  {
-    return ssh_bind_options_set(bind, Option, &value) == SSH_OK;
-  }
-};
+  using handle_type = ssh_bind;
+  using detail::basic_option<ssh_bind_options_e, Option, T>::basic_option;
 
-template<ssh_bind_options_e Option>
-struct bind_option<Option, const char *>
-{
-  constexpr static ssh_bind_options_e option = Option;
-  using value_type = const char *;
-  value_type value = {};
-  bind_option() = default;
-  explicit bind_option(value_type value) : value(value) {}
+  /// A bind can have one host key per key type, so these can be given more than once.
+  constexpr static bool repeatable = Option == SSH_BIND_OPTIONS_HOSTKEY || Option == SSH_BIND_OPTIONS_IMPORT_KEY;
 
   bool apply(ssh_bind bind) const
   {
-    return ssh_bind_options_set(bind, Option, value) == SSH_OK;
+    return ssh_bind_options_set(bind, Option, detail::option_pointer(this->value)) == SSH_OK;
   }
 };
 
+template<ssh_bind_options_e Option, typename T>
+constexpr bool bind_option<Option, T>::repeatable;
 
 using bindaddr                  = bind_option<SSH_BIND_OPTIONS_BINDADDR,                  const char *>;
 using bindport                  = bind_option<SSH_BIND_OPTIONS_BINDPORT,                  unsigned >;
@@ -84,7 +76,7 @@ bool apply_config(ssh_bind bind, const bind_option<Option, T> & bo)
 }
 
 template<ssh_bind_options_e Option, typename T>
-bool apply_config(unique_handle<ssh_bind> bind, const bind_option<Option, T> & bo)
+bool apply_config(const detail::unique_handle<ssh_bind, ssh_bind_free> & bind, const bind_option<Option, T> & bo)
 {
   return bo.apply(bind.get());
 }
@@ -95,69 +87,113 @@ namespace detail
 template<typename Protocol, typename Executor>
 struct initiate_async_accept
 {
-  boost::asio::basic_socket_acceptor<Protocol, Executor> & acceptor;
+  net::basic_socket_acceptor<Protocol, Executor> & acceptor;
+  ssh_bind bind;
   error_info * ei = nullptr;
-  unique_handle<ssh_session> session;
+  session_handle_pool * pool = nullptr;
 
   template<typename Self>
   void operator()(Self && self)
   {
+    ASIOFY_LIBSSH_TRACE_WAIT(0u, op_kind::accept, net::socket_base::wait_read);
     acceptor.async_accept(std::move(self));
   }
-  template<typename Self>
-  void operator()(Self && self, error_code ec,
-                  net::basic_stream_socket<net::generic::stream_protocol, Executor> socket)
+
+  template<typename Self, typename Socket>
+  void operator()(Self && self, error_code ec, Socket socket)
   {
     if (ec)
-      return self.complete(ec, std::move(*session));
-    session.reset(ssh_new());
-    auto code = ssh_bind_accept_fd(session.get(), session.get(), socket.release(ec));
-    if (code != SSH_OK)
+      return self.complete(ec, session_handle{});
+    session_handle session = pool != nullptr ? pool->acquire() : session_handle{ssh_new()};
+    const auto fd = socket.release(ec);
+    if (ec)
+      return self.complete(ec, session_handle{});
+
+    const int res = ssh_bind_accept_fd(bind, session.get(), fd);
+    ASIOFY_LIBSSH_TRACE_CALL(0u, op_kind::accept, res, 0);
+    if (res != SSH_OK)
     {
-      ASIOFY_ASSIGN_EC(ec, code, ssh_category());
+      ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(bind), ssh_category());
       if (ei != nullptr)
-        ei->set_message(ssh_get_error(session.get()));
+        ei->set_message(ssh_get_error(bind));
       session.reset();
     }
     return self.complete(ec, std::move(session));
   }
 };
+
+// the protocol of a descriptor libssh opened, so it can be assigned to a socket.
+inline net::generic::stream_protocol protocol_of(socket_t fd, error_code & ec)
+{
+  net::generic::stream_protocol::endpoint ep;
+  auto len = static_cast<socklen_t>(ep.capacity());
+  if (::getsockname(fd, ep.data(), &len) != 0)
+  {
+#if defined(ASIOFY_WINDOWS)
+    ASIOFY_ASSIGN_EC(ec, WSAGetLastError(), net::error::get_system_category());
+#else
+    ASIOFY_ASSIGN_EC(ec, errno, net::error::get_system_category());
+#endif
+    return net::generic::stream_protocol(AF_UNSPEC, 0);
+  }
+  ep.resize(len);
+  return ep.protocol();
 }
 
+}
+
+/// Accept a connection on `acceptor` and set it up as a session of `bind`.
+/** The key exchange still needs to be performed with `async_handle_key_exchange`. */
 template<typename Protocol,
          typename Executor,
-         BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, unique_handle<ssh_session>)) AcceptToken
-           BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
-BOOST_ASIO_INITFN_RESULT_TYPE(AcceptToken, void(error_code, unique_handle<ssh_session>))
+         ASIOFY_COMPLETION_TOKEN_FOR(void(error_code, session_handle)) AcceptToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void(error_code, session_handle))
 async_accept(
-    boost::asio::basic_socket_acceptor<Protocol, Executor> & acceptor,
+    net::basic_socket_acceptor<Protocol, Executor> & acceptor,
+    ssh_bind bind,
     error_info & ei,
-    AcceptToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))
+    AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
 {
-  return net::async_compose<AcceptToken, void(error_code, unique_handle<ssh_session>)>
+  return net::async_compose<AcceptToken, void(error_code, session_handle)>
   (
-      detail::initiate_async_accept<Protocol, Executor>{acceptor, &ei}, token
+      detail::initiate_async_accept<Protocol, Executor>{acceptor, bind, &ei}, token, acceptor
   );
 }
 
 template<typename Protocol,
          typename Executor,
-         BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, unique_handle<ssh_session>)) AcceptToken
-           BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
-BOOST_ASIO_INITFN_RESULT_TYPE(AcceptToken, void(error_code, unique_handle<ssh_session>))
+         ASIOFY_COMPLETION_TOKEN_FOR(void(error_code, session_handle)) AcceptToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void(error_code, session_handle))
 async_accept(
-    boost::asio::basic_socket_acceptor<Protocol, Executor> & acceptor,
-    AcceptToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))
+    net::basic_socket_acceptor<Protocol, Executor> & acceptor,
+    ssh_bind bind,
+    AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
 {
-  return net::async_compose<AcceptToken, void(error_code, unique_handle<ssh_session>)>
+  return net::async_compose<AcceptToken, void(error_code, session_handle)>
   (
-      detail::initiate_async_accept<Protocol, Executor>{acceptor}, token
+      detail::initiate_async_accept<Protocol, Executor>{acceptor, bind}, token, acceptor
   );
 }
 
-
-
-
+/// Accept a connection with a session taken from `pool`, which it gets returned to when the handle is destroyed.
+template<typename Protocol,
+         typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void(error_code, session_handle)) AcceptToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void(error_code, session_handle))
+async_accept(
+    net::basic_socket_acceptor<Protocol, Executor> & acceptor,
+    ssh_bind bind,
+    session_handle_pool & pool,
+    AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<AcceptToken, void(error_code, session_handle)>
+  (
+      detail::initiate_async_accept<Protocol, Executor>{acceptor, bind, nullptr, &pool}, token, acceptor
+  );
+}
 
 template<typename Executor = net::any_io_executor>
 struct basic_bind
@@ -190,7 +226,7 @@ struct basic_bind
                          typename std::enable_if<
                              std::is_convertible<ExecutionContext&, net::execution_context&>::value,
                              int>::type = 0)
-      : acceptor_(context.get_executor())
+      : acceptor_(context)
   {
   }
   basic_bind(const executor_type& ex,
@@ -204,31 +240,31 @@ struct basic_bind
                 const native_handle_type& native_handle,
                 typename std::enable_if<
                     std::is_convertible<ExecutionContext&, net::execution_context&>::value,
-                    int >::type = 0) : acceptor_(context.get_executor()), handle_(native_handle)
+                    int >::type = 0) : acceptor_(context), handle_(native_handle)
   {
   }
 
-  basic_bind(basic_bind&& other)
-      : acceptor_(other.acceptor_), handle_(std::move(other.handle_))
-  {
-  }
+  basic_bind(basic_bind&& other) = default;
 
   basic_bind& operator=(basic_bind&& other)
   {
+    // the listening socket is owned by libssh.
+    error_code ec;
+    acceptor_.release(ec);
     acceptor_ = std::move(other.acceptor_);
     handle_ = std::move(other.handle_);
     return *this;
   }
 
-  // All pipes have access to each other's implementations.
+  // All binds have access to each other's implementations.
   template <typename Executor1>
-  friend class basic_bind;
+  friend struct basic_bind;
 
   template <typename Executor1>
   basic_bind(basic_bind<Executor1>&& other,
                 typename std::enable_if<
                     std::is_convertible<Executor1, Executor>::value, int>::type = 0)
-      : acceptor_(other.acceptor_), handle_(std::move(other.handle_))
+      : acceptor_(std::move(other.acceptor_)), handle_(std::move(other.handle_))
   {
   }
 
@@ -238,11 +274,14 @@ struct basic_bind
         basic_bind&
     >::type operator=(basic_bind<Executor1>&& other)
   {
-    acceptor_ = other.acceptor_;
+    error_code ec;
+    acceptor_.release(ec);
+    acceptor_ = std::move(other.acceptor_);
     handle_ = std::move(other.handle_);
     return *this;
   }
-  const executor_type& get_executor() BOOST_ASIO_NOEXCEPT
+
+  executor_type get_executor() noexcept
   {
     return acceptor_.get_executor();
   }
@@ -270,35 +309,48 @@ struct basic_bind
   {
     return ssh_bind_options_set(handle_.get(), type, &value) == SSH_OK;
   }
+  /// Used for SSH_BIND_OPTIONS_IMPORT_KEY, the bind takes ownership of the key.
+  bool options_set(enum ssh_bind_options_e type, ssh_key value)
+  {
+    return ssh_bind_options_set(handle_.get(), type, value) == SSH_OK;
+  }
   bool options_parse_config(const char * filename)
   {
     return ssh_bind_options_parse_config(handle_.get(), filename) == SSH_OK;
-      ASIOFY_LIBSSH_THROW_ERROR(handle_.get());
   }
 
   void listen()
   {
-    int res = ssh_bind_listen(handle_.get());
-    if (res != SSH_OK)
-      ASIOFY_LIBSSH_THROW_ERROR(handle_.get());
+    error_code ec;
+    error_info ei;
+    listen(ec, ei);
+    if (ec)
+      throw_exception(system_error(ec, ei.message()));
   }
 
   void listen(error_code & ec, error_info & ei)
   {
     int res = ssh_bind_listen(handle_.get());
+    ASIOFY_LIBSSH_TRACE_CALL(0u, op_kind::other, res, 0);
     if (res != SSH_OK)
+    {
       ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get());
+      return;
+    }
+    // libssh owns the listening socket, the acceptor only waits on it.
+    const auto fd = ssh_bind_get_fd(handle_.get());
+    const auto protocol = detail::protocol_of(fd, ec);
+    if (!ec)
+      acceptor_.assign(protocol, fd, ec);
   }
 
-
   basic_session<executor_type> accept()
   {
-    basic_session<executor_type> sess{get_executor()};
-    ssh_bind_set_blocking(handle_.get(), 1);
-    int res = ssh_bind_accept(handle_.get(), sess.native_handle());
-    if (res != SSH_OK)
-      ASIOFY_LIBSSH_THROW_ERROR(handle_.get());
-
+    error_code ec;
+    error_info ei;
+    auto sess = accept(ec, ei);
+    if (ec)
+      throw_exception(system_error(ec, ei.message()));
     return sess;
   }
 
@@ -307,33 +359,104 @@ struct basic_bind
     basic_session<executor_type> sess{get_executor()};
     ssh_bind_set_blocking(handle_.get(), 1);
     int res = ssh_bind_accept(handle_.get(), sess.native_handle());
+    ASIOFY_LIBSSH_TRACE_CALL(sess.id(), op_kind::accept, res, 0);
     if (res != SSH_OK)
-      ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get());
+      ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get())
+    else
+      assign_next_layer(sess, ssh_get_fd(sess.native_handle()), ec);
     return sess;
   }
 
-    template <BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code, basic_session<executor_type>)) ConnectToken
-    BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-      BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void (error_code, basic_session<executor_type>))
-  async_accept(ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+  /// Set up `sess` as a server session on a descriptor that is already connected, e.g. one end of a socketpair.
+  /** Ownership of `fd` passes to the session. The key exchange still needs to be performed. */
+  template<typename Executor1>
+  void accept_fd(basic_session<Executor1> & sess, socket_t fd)
   {
-    return net::async_compose<ConnectToken, void (error_code, basic_session<executor_type>)>
+    error_code ec;
+    error_info ei;
+    accept_fd(sess, fd, ec, ei);
+    if (ec)
+      throw_exception(system_error(ec, ei.message()));
+  }
+
+  template<typename Executor1>
+  void accept_fd(basic_session<Executor1> & sess, socket_t fd, error_code & ec, error_info & ei)
+  {
+    const int res = ssh_bind_accept_fd(handle_.get(), sess.native_handle(), fd);
+    ASIOFY_LIBSSH_TRACE_CALL(sess.id(), op_kind::accept, res, 0);
+    if (res != SSH_OK)
+      ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, handle_.get())
+    else
+      assign_next_layer(sess, fd, ec);
+  }
+
+  /// Accept a session, `listen` must have been called before. The key exchange still needs to be performed.
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, basic_session<executor_type>)) AcceptToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void (error_code, basic_session<executor_type>))
+  async_accept(AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return net::async_compose<AcceptToken, void (error_code, basic_session<executor_type>)>
         (
-            initiate_async_accept{this}, token, acceptor_
+            initiate_async_accept<executor_type>{this, get_executor()}, token, acceptor_
         );
   }
 
-
-  template <BOOST_ASIO_COMPLETION_TOKEN_FOR(void(error_code, basic_session<executor_type>)) ConnectToken
-    BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
-      BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void(error_code, basic_session<executor_type>))
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void(error_code, basic_session<executor_type>)) AcceptToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void(error_code, basic_session<executor_type>))
   async_accept(
       error_info & ei,
-      ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+      AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return net::async_compose<AcceptToken, void(error_code, basic_session<executor_type>)>
+        (
+            initiate_async_accept<executor_type>{this, get_executor(), &ei}, token, acceptor_
+        );
+  }
+
+  /// Accept a session that uses `ex`, e.g. its own strand, so sessions can run concurrently on a thread pool.
+  template <typename Executor1,
+            ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, basic_session<Executor1>)) AcceptToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void (error_code, basic_session<Executor1>))
+  async_accept(const Executor1 & ex,
+               AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type),
+               typename std::enable_if<
+                   net::execution::is_executor<Executor1>::value || net::is_executor<Executor1>::value
+               >::type * = nullptr)
+  {
+    return net::async_compose<AcceptToken, void (error_code, basic_session<Executor1>)>
+        (
+            initiate_async_accept<Executor1>{this, ex}, token, acceptor_
+        );
+  }
+
+  /// Accept a session with a handle taken from `pool`, which it gets returned to when the session is destroyed.
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, basic_session<executor_type>)) AcceptToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void (error_code, basic_session<executor_type>))
+  async_accept(session_handle_pool & pool,
+               AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
   {
-    return net::async_compose<ConnectToken, void(error_code, basic_session<executor_type>)>
+    return net::async_compose<AcceptToken, void (error_code, basic_session<executor_type>)>
         (
-            initiate_async_accept{this, &ei}, token, acceptor_
+            initiate_async_accept<executor_type>{this, get_executor(), nullptr, &pool}, token, acceptor_
+        );
+  }
+
+  /// Accept a session that uses `ex` with a handle taken from `pool`.
+  template <typename Executor1,
+            ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, basic_session<Executor1>)) AcceptToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcceptToken, void (error_code, basic_session<Executor1>))
+  async_accept(const Executor1 & ex,
+               session_handle_pool & pool,
+               AcceptToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return net::async_compose<AcceptToken, void (error_code, basic_session<Executor1>)>
+        (
+            initiate_async_accept<Executor1>{this, ex, nullptr, &pool}, token, acceptor_
         );
   }
 
@@ -344,37 +467,70 @@ struct basic_bind
   }
 
  private:
+  template<typename Executor1>
+  void assign_next_layer(basic_session<Executor1> & sess, socket_t fd, error_code & ec)
+  {
+    const auto protocol = detail::protocol_of(fd, ec);
+    if (!ec)
+      sess.next_layer().assign(protocol, fd, ec);
+    // the session owns the descriptor, whether it was accepted by libssh or handed to it.
+    if (!ec)
+      sess.next_layer().disown();
+  }
+
+  template<typename SessionExecutor>
   struct initiate_async_accept
   {
-      basic_bind * this_;
-      error_info * ei = nullptr;
-      std::shared_ptr<basic_session<executor_type>> session;
-
-      template<typename Self>
-      void operator()(Self && self)
-      {
-        ssh_bind_set_blocking(this_->handle_.get(), 0);
-        session = std::allocate_shared<basic_session<executor_type>>(self.get_allocator(), this_->get_executor());
-        this_->acceptor_.template async_accept(net::socket_base::wait_read, std::move(self));
-      }
-      template<typename Self>
-      void operator()(Self && self, error_code ec,
-                      net::basic_stream_socket<net::generic::stream_protocol, executor_type> socket)
-      {
-        if (ec)
-          return self.complete(ec, std::move(*session));
-
-        ssh_bind_accept_fd(this_->native_handle(), session->native_handle(), socket.release(ec));
-        return self.complete(ec, std::move(*session));
-      }
+    basic_bind * this_;
+    SessionExecutor session_executor;
+    error_info * ei = nullptr;
+    session_handle_pool * pool = nullptr;
+    detail::op_instrument<op_kind::accept> instrument = {};
+
+    template<typename Self>
+    void operator()(Self && self)
+    {
+      ASIOFY_LIBSSH_TRACE_WAIT(0u, op_kind::accept, net::socket_base::wait_read);
+      this_->acceptor_.async_accept(std::move(self));
+    }
+
+    template<typename Self, typename Socket>
+    void operator()(Self && self, error_code ec, Socket socket)
+    {
+      basic_session<SessionExecutor> sess = pool != nullptr
+          ? basic_session<SessionExecutor>{session_executor, pool->acquire()}
+          : basic_session<SessionExecutor>{session_executor};
+      if (ec)
+        return self.complete(ec, std::move(sess));
+
+      // the latency of an accept starts with the connection, not with the wait for it.
+      instrument.initiated(sess);
+      const auto fd = socket.release(ec);
+      error_info ei_;
+      if (!ec)
+        this_->accept_fd(sess, fd, ec, ei != nullptr ? *ei : ei_);
+      instrument.finished(sess, ec);
+      return self.complete(ec, std::move(sess));
+    }
   };
 
   net::basic_socket_acceptor<net::generic::stream_protocol, executor_type> acceptor_;
-  detail::unique_handle<ssh_bind> handle_{ssh_bind_new()};
+  detail::unique_handle<ssh_bind, ssh_bind_free> handle_{ssh_bind_new()};
 };
 
+/// A bind using the executor of an io_context directly.
+/** To accept sessions onto their own strands, use `async_accept(net::make_strand(ctx), token)`. */
+using io_bind = basic_bind<net::io_context::executor_type>;
+
+#define ASIOFY_LIBSSH_INSTANTIATE_BIND(Extern, Executor)                                                             \
+  Extern template struct basic_bind<Executor>;                                                                       \
+  Extern template void basic_bind<Executor>::accept_fd(basic_session<Executor> &, socket_t, error_code &, error_info &);
+
+#if defined(ASIOFY_SEPARATE_COMPILATION)
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_BIND, extern)
+#endif
+
 }
 }
 
-
 #endif //ASIOFY_LIBSSH_BASIC_BIND_HPP
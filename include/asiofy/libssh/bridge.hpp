@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_BRIDGE_HPP
+#define ASIOFY_LIBSSH_BRIDGE_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/detail/pump.hpp>
+
+#include <memory>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+namespace detail
+{
+
+template<typename Executor>
+struct initiate_async_bridge
+{
+  template<typename Handler, typename Stream>
+  void operator()(Handler && handler, basic_channel<Executor> * channel, Stream * stream, std::size_t buffer_size)
+  {
+    using state_type = pump_state<Executor, pump_channel<Executor>, Stream&, typename std::decay<Handler>::type>;
+    auto st = std::allocate_shared<state_type>(channel->session().get_allocator(),
+                                               channel->get_executor(), channel->session().get_allocator(),
+                                               pump_channel<Executor>{*channel}, *stream,
+                                               buffer_size, std::forward<Handler>(handler));
+    start_pump(st);
+  }
+};
+
+}
+
+/// Pump data between a channel and a stream in both directions until both sides sent eof.
+/** An eof from the stream gets forwarded with `send_eof`, an eof from the channel shuts down the sending side
+ * of the stream, if it has a `shutdown` function. If either direction fails, the other one gets aborted by closing
+ * the stream, if it has a `close` function, and the channel.
+ *
+ * Each direction uses a fixed buffer of `buffer_size` bytes, that is allocated once.
+ * The stream needs to use the same executor as the channel, or one that runs on the same thread.
+ */
+template<typename Executor, typename Stream,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) BridgeToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(BridgeToken, void (error_code))
+async_bridge(basic_channel<Executor> & channel, Stream & stream, std::size_t buffer_size,
+             BridgeToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_initiate<BridgeToken, void(error_code)>(
+      detail::initiate_async_bridge<Executor>{}, token, &channel, &stream, buffer_size);
+}
+
+template<typename Executor, typename Stream,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) BridgeToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(BridgeToken, void (error_code))
+async_bridge(basic_channel<Executor> & channel, Stream & stream,
+             BridgeToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_initiate<BridgeToken, void(error_code)>(
+      detail::initiate_async_bridge<Executor>{}, token, &channel, &stream, std::size_t(32768u));
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_BRIDGE_HPP
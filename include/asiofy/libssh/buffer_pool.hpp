@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_BUFFER_POOL_HPP
+#define ASIOFY_LIBSSH_BUFFER_POOL_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/buffer.hpp>
+#else
+#include <boost/asio/buffer.hpp>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+class buffer_pool;
+
+namespace detail
+{
+
+// the header of a pooled buffer, the data follows it in the same allocation.
+struct buffer_block
+{
+  std::atomic<std::size_t> refs{1u};
+  buffer_pool * pool;
+  std::size_t size;
+
+  buffer_block(buffer_pool * p, std::size_t n) : pool(p), size(n) {}
+
+  char * data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+}
+
+/// A refcounted buffer taken from a `buffer_pool`, it goes back when the last copy is released.
+/** Copies share the same memory, so it should only be written to while `use_count() == 1`. */
+class pooled_buffer
+{
+ public:
+  pooled_buffer() noexcept = default;
+
+  pooled_buffer(const pooled_buffer & other) noexcept : block_(other.block_)
+  {
+    if (block_ != nullptr)
+      block_->refs.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  pooled_buffer(pooled_buffer && other) noexcept : block_(other.block_)
+  {
+    other.block_ = nullptr;
+  }
+
+  pooled_buffer& operator=(pooled_buffer other) noexcept
+  {
+    std::swap(block_, other.block_);
+    return *this;
+  }
+
+  ~pooled_buffer() { reset(); }
+
+  /// Give up this reference, the buffer goes back to the pool if it was the last one.
+  inline void reset() noexcept;
+
+        void * data()       noexcept { return block_ != nullptr ? block_->data() : nullptr; }
+  const void * data() const noexcept { return block_ != nullptr ? block_->data() : nullptr; }
+
+  /// The number of valid bytes, after a read the number of bytes received.
+  std::size_t size() const noexcept { return block_ != nullptr ? block_->size : 0u; }
+  bool empty() const noexcept { return size() == 0u; }
+
+  /// The size of the memory, i.e. the `buffer_size` of the pool.
+  inline std::size_t capacity() const noexcept;
+
+  /// Set the number of valid bytes, at most `capacity()`.
+  void resize(std::size_t n) noexcept
+  {
+    assert(n <= capacity());
+    if (block_ != nullptr)
+      block_->size = n;
+  }
+
+  /// The valid bytes as an asio buffer.
+  net::const_buffer buffer() const noexcept { return net::const_buffer(data(), size()); }
+
+  std::size_t use_count() const noexcept
+  {
+    return block_ != nullptr ? block_->refs.load(std::memory_order_relaxed) : 0u;
+  }
+
+  explicit operator bool() const noexcept { return block_ != nullptr; }
+
+ private:
+  friend class buffer_pool;
+  explicit pooled_buffer(detail::buffer_block * block) noexcept : block_(block) {}
+
+  detail::buffer_block * block_ = nullptr;
+};
+
+/// A pool of fixed-size buffers, that channel reads borrow from once data is available.
+/** Instead of every reader keeping its own buffer, the memory in use scales with the traffic.
+ * Buffers given back are kept up to `max_idle`, the rest is freed.
+ *
+ * It can be shared between threads & sessions. The pool must outlive all buffers taken from it.
+ */
+class buffer_pool
+{
+ public:
+  /// @param buffer_size The size of each buffer, i.e. the most a single read can return.
+  /// @param max_idle The number of buffers kept, any returned beyond that get freed.
+  explicit buffer_pool(std::size_t buffer_size = 16384u, std::size_t max_idle = 64u)
+      : buffer_size_(buffer_size), max_idle_(max_idle)
+  {
+  }
+
+  buffer_pool(const buffer_pool &) = delete;
+  buffer_pool& operator=(const buffer_pool &) = delete;
+
+  ~buffer_pool()
+  {
+    assert(in_use() == 0u);
+    for (auto block : idle_)
+      free(block);
+  }
+
+  /// Take a buffer from the pool, or allocate one if it's empty. Its size is the full `buffer_size`.
+  pooled_buffer acquire()
+  {
+    detail::buffer_block * block = nullptr;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (!idle_.empty())
+      {
+        block = idle_.back();
+        idle_.pop_back();
+      }
+    }
+    if (block != nullptr)
+    {
+      reused_.fetch_add(1u, std::memory_order_relaxed);
+      block->refs.store(1u, std::memory_order_relaxed);
+      block->size = buffer_size_;
+    }
+    else
+    {
+      block = allocate();
+      created_.fetch_add(1u, std::memory_order_relaxed);
+    }
+    in_use_.fetch_add(1u, std::memory_order_relaxed);
+    return pooled_buffer{block};
+  }
+
+  /// Allocate buffers up front, so the first `n` acquires don't allocate.
+  void reserve(std::size_t n)
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    idle_.reserve(max_idle_);
+    while (idle_.size() < (std::min)(n, max_idle_))
+    {
+      idle_.push_back(allocate());
+      created_.fetch_add(1u, std::memory_order_relaxed);
+    }
+  }
+
+  /// Free all idle buffers.
+  void shrink()
+  {
+    std::vector<detail::buffer_block*> idle;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      idle.swap(idle_);
+    }
+    for (auto block : idle)
+      free(block);
+  }
+
+  std::size_t buffer_size() const { return buffer_size_; }
+
+  /// The number of buffers waiting to be reused.
+  std::size_t idle() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return idle_.size();
+  }
+
+  /// The number of buffers currently held by a `pooled_buffer`.
+  std::size_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+
+  /// The number of buffers allocated.
+  std::uint64_t created() const { return created_.load(std::memory_order_relaxed); }
+  /// The number of acquires served from the pool.
+  std::uint64_t reused()  const { return reused_.load(std::memory_order_relaxed); }
+
+ private:
+  friend class pooled_buffer;
+
+  detail::buffer_block * allocate()
+  {
+    void * p = ::operator new(sizeof(detail::buffer_block) + buffer_size_);
+    return ::new (p) detail::buffer_block(this, buffer_size_);
+  }
+
+  static void free(detail::buffer_block * block)
+  {
+    block->~buffer_block();
+    ::operator delete(block);
+  }
+
+  void release(detail::buffer_block * block)
+  {
+    in_use_.fetch_sub(1u, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (idle_.size() < max_idle_)
+      {
+        idle_.push_back(block);
+        return;
+      }
+    }
+    free(block);
+  }
+
+  const std::size_t buffer_size_, max_idle_;
+  mutable std::mutex mutex_;
+  std::vector<detail::buffer_block*> idle_;
+  std::atomic<std::size_t> in_use_{0u};
+  std::atomic<std::uint64_t> created_{0u}, reused_{0u};
+};
+
+void pooled_buffer::reset() noexcept
+{
+  if (block_ != nullptr && block_->refs.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+    block_->pool->release(block_);
+  block_ = nullptr;
+}
+
+std::size_t pooled_buffer::capacity() const noexcept
+{
+  return block_ != nullptr ? block_->pool->buffer_size() : 0u;
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_BUFFER_POOL_HPP
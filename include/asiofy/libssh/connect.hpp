@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_CONNECT_HPP
+#define ASIOFY_LIBSSH_CONNECT_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/error.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/connect.hpp>
+#include <asio/coroutine.hpp>
+#include <asio/ip/tcp.hpp>
+#else
+#include <boost/asio/connect.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#endif
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+namespace detail
+{
+
+inline error_code check_known_server(ssh_session sess)
+{
+  error_code ec;
+  switch (ssh_session_is_known_server(sess))
+  {
+    case SSH_KNOWN_HOSTS_OK:
+      break;
+    case SSH_KNOWN_HOSTS_CHANGED:
+    case SSH_KNOWN_HOSTS_OTHER:
+      ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::host_key_changed), asiofy_category());
+      break;
+    case SSH_KNOWN_HOSTS_UNKNOWN:
+    case SSH_KNOWN_HOSTS_NOT_FOUND:
+      ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::host_key_unknown), asiofy_category());
+      break;
+    case SSH_KNOWN_HOSTS_ERROR:
+    default:
+      ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess), ssh_category());
+      break;
+  }
+  return ec;
+}
+
+// key exchange, host key verification & authentication on an already connected next_layer.
+template<typename Executor>
+struct async_handshake_op : net::coroutine
+{
+  basic_session<Executor> & sess;
+  std::string user;
+  error_info * ei;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      sess.options_set(SSH_OPTIONS_USER, user.c_str());
+      if (ei)
+      {
+        ASIOFY_CORO_YIELD sess.async_connect(*ei, std::move(self));
+      }
+      else
+      {
+        ASIOFY_CORO_YIELD sess.async_connect(std::move(self));
+      }
+      if (ec)
+        return self.complete(ec);
+
+      ec = check_known_server(sess.native_handle());
+      if (ec)
+        return self.complete(ec);
+
+      if (ei)
+      {
+        ASIOFY_CORO_YIELD sess.async_userauth_publickey_auto(nullptr, nullptr, *ei, std::move(self));
+      }
+      else
+      {
+        ASIOFY_CORO_YIELD sess.async_userauth_publickey_auto(nullptr, nullptr, std::move(self));
+      }
+      self.complete(ec);
+    }
+  }
+};
+
+template<typename Executor, typename EndpointSequence>
+struct async_connect_endpoints_op : net::coroutine
+{
+  basic_session<Executor> & sess;
+  EndpointSequence endpoints;
+  std::string user;
+  error_info * ei;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec, const net::generic::stream_protocol::endpoint & )
+  {
+    (*this)(std::move(self), ec);
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      ASIOFY_CORO_YIELD net::async_connect(sess.next_layer(), endpoints, std::move(self));
+      if (ec)
+      {
+        // the socket is left open after the last endpoint failed, libssh never got it.
+        error_code ig;
+        sess.next_layer().close(ig);
+        return self.complete(ec);
+      }
+
+      ASIOFY_CORO_YIELD net::async_compose<typename std::decay<Self>::type, void(error_code)>(
+            async_handshake_op<Executor>{{}, sess, std::move(user), ei}, self, sess);
+      self.complete(ec);
+    }
+  }
+};
+
+template<typename Executor>
+struct async_connect_host_op : net::coroutine
+{
+  using resolver_type = net::ip::basic_resolver<net::ip::tcp, Executor>;
+  basic_session<Executor> & sess;
+  std::string host;
+  std::string port;
+  std::string user;
+  error_info * ei;
+  std::unique_ptr<resolver_type> resolver;
+  // the generic endpoint can't be constructed from a resolver entry directly.
+  std::vector<net::generic::stream_protocol::endpoint> endpoints;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec, typename resolver_type::results_type results)
+  {
+    if (!ec)
+      for (const auto & entry : results)
+        endpoints.emplace_back(entry.endpoint());
+    resolver.reset();
+    (*this)(std::move(self), ec);
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      resolver.reset(new resolver_type(sess.get_executor()));
+      ASIOFY_CORO_YIELD resolver->async_resolve(host, port, std::move(self));
+      if (ec)
+        return self.complete(ec);
+
+      sess.options_set(SSH_OPTIONS_HOST, host.c_str());
+      sess.options_set(SSH_OPTIONS_PORT_STR, port.c_str());
+      ASIOFY_CORO_YIELD net::async_compose<typename std::decay<Self>::type, void(error_code)>(
+            async_connect_endpoints_op<Executor, std::vector<net::generic::stream_protocol::endpoint>>{
+              {}, sess, std::move(endpoints), std::move(user), ei},
+            self, sess);
+      self.complete(ec);
+    }
+  }
+};
+
+}
+
+/// Connect the session to any of `endpoints`, perform the key exchange, verify the host key against known_hosts
+/// and authenticate as `user` with publickey auto.
+/** The hostname used to look up known_hosts needs to be set through SSH_OPTIONS_HOST beforehand. */
+template<typename Executor, typename EndpointSequence,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+async_connect(basic_session<Executor> & sess, const EndpointSequence & endpoints, std::string user,
+              ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<ConnectToken, void (error_code)>
+      (
+          detail::async_connect_endpoints_op<Executor, EndpointSequence>{{}, sess, endpoints, std::move(user), nullptr},
+          token, sess
+      );
+}
+
+/// Resolve `host`, then connect, verify & authenticate as described above.
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+async_connect(basic_session<Executor> & sess, std::string host, unsigned short port, std::string user,
+              ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<ConnectToken, void (error_code)>
+      (
+          detail::async_connect_host_op<Executor>{
+              {}, sess, std::move(host), std::to_string(port), std::move(user), nullptr, nullptr, {}},
+          token, sess
+      );
+}
+
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+async_connect(basic_session<Executor> & sess, std::string host, unsigned short port, std::string user,
+              error_info & ei,
+              ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<ConnectToken, void (error_code)>
+      (
+          detail::async_connect_host_op<Executor>{
+              {}, sess, std::move(host), std::to_string(port), std::move(user), &ei, nullptr, {}},
+          token, sess
+      );
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_CONNECT_HPP
@@ -33,10 +33,24 @@
     throw_exception(system_error(ec, ssh_get_error(Handle)));         \
   }
 
-#define ASIOFY_COMPLETION_TOKEN_FOR(...)          BOOST_ASIO_COMPLETION_TOKEN_FOR(__VA_ARGS__)
-#define ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(...) BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(__VA_ARGS__)
-#define ASIOFY_INITFN_RESULT_TYPE(...)            BOOST_ASIO_INITFN_RESULT_TYPE(__VA_ARGS__)
-#define ASIOFY_DEFAULT_COMPLETION_TOKEN(...)      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(__VA_ARGS__)
-
+// With ASIOFY_SEPARATE_COMPILATION the headers declare the instantiations for these executors extern,
+// they get compiled once into the asiofy_libssh library (src/libssh.cpp).
+// The library needs to be built with the same ASIOFY_LIBSSH_ENABLE_* definitions as its users.
+#if defined(ASIOFY_SEPARATE_COMPILATION)
+#if defined(ASIOFY_STANDALONE)
+#include <asio/any_io_executor.hpp>
+#include <asio/io_context.hpp>
+#include <asio/strand.hpp>
+#else
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#endif
+
+#define ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(Macro, Extern)                                                               \
+  Macro(Extern, ::asiofy::net::any_io_executor)                                                                      \
+  Macro(Extern, ::asiofy::net::io_context::executor_type)                                                            \
+  Macro(Extern, ::asiofy::net::strand<::asiofy::net::io_context::executor_type>)
+#endif
 
 #endif //ASIOFY_LIBSSH_DETAIL_CONFIG_HPP
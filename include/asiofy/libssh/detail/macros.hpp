@@ -9,9 +9,16 @@
 #define ASIOFY_LIBSSH_DETAIL_MACROS_HPP
 
 #include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/memory.hpp>
+#include <asiofy/libssh/detail/trace.hpp>
 #include <asiofy/libssh/error.hpp>
+#include <asiofy/libssh/stats.hpp>
 
+#if defined(ASIOFY_STANDALONE)
+#include <asio/socket_base.hpp>
+#else
 #include <boost/asio/socket_base.hpp>
+#endif
 #include <libssh/libssh.h>
 
 namespace asiofy
@@ -27,37 +34,45 @@ namespace detail
 
 template<typename Executor,
          int (*Func)(ssh_session),
-         net::socket_base::wait_type WaitType>
+         net::socket_base::wait_type WaitType,
+         op_kind Kind = op_kind::other>
 struct async_wrap_session_async_call_0
 {
   basic_session<Executor> & sess;
   error_info * ei;
+  op_instrument<Kind> instrument = {};
+
   template<typename Self>
   void operator()(Self && self)
   {
+    instrument.initiated(sess);
     ssh_set_blocking(sess.native_handle(), 0);
-    sess.next_layer().async_wait(net::socket_base::wait_read, std::move(self));
+    instrument.waiting(sess, net::socket_base::wait_read);
+    detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
   }
 
   template<typename Self>
   void operator()(Self && self, error_code ec)
   {
+    instrument.woken(sess);
     if (ec)
-      return self.complete(ec);
-    int res = Func(sess.native_handle());
+      return instrument.complete(sess, self, ec);
+    int res = instrument.call(sess, [&]{ return Func(sess.native_handle()); });
     switch(res)
     {
       case SSH_OK:
-        return self.complete(ec);
+        return instrument.complete(sess, self, ec);
       case SSH_ERROR:
       {
         if (ei)
           ei->set_message(ssh_get_error(sess.native_handle()));
-        constexpr static boost::source_location loc = BOOST_CURRENT_LOCATION;
-        return self.complete(error_code(ssh_get_error_code(sess.native_handle()), ssh_category(), &loc));
+        ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+        return instrument.complete(sess, self, ec);
       }
       case SSH_AGAIN:
-        return sess.next_layer().async_wait(WaitType, std::move(self));
+        instrument.retried(sess);
+        instrument.waiting(sess, WaitType);
+        return detail::async_wait(sess, WaitType, std::move(self));
     }
   }
 };
@@ -65,38 +80,46 @@ struct async_wrap_session_async_call_0
 template<typename Executor,
     typename Arg0,
     int (*Func)(ssh_session, Arg0),
-    net::socket_base::wait_type WaitType>
+    net::socket_base::wait_type WaitType,
+    op_kind Kind = op_kind::other>
 struct async_wrap_session_async_call_1
 {
   basic_session<Executor> & sess;
   Arg0 arg0;
   error_info * ei;
+  op_instrument<Kind> instrument = {};
+
   template<typename Self>
   void operator()(Self && self)
   {
+    instrument.initiated(sess);
     ssh_set_blocking(sess.native_handle(), 0);
-    sess.next_layer().async_wait(net::socket_base::wait_read, std::move(self));
+    instrument.waiting(sess, net::socket_base::wait_read);
+    detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
   }
 
   template<typename Self>
   void operator()(Self && self, error_code ec)
   {
+    instrument.woken(sess);
     if (ec)
-      return self.complete(ec);
-    int res = Func(sess.native_handle(), arg0);
+      return instrument.complete(sess, self, ec);
+    int res = instrument.call(sess, [&]{ return Func(sess.native_handle(), arg0); });
     switch(res)
     {
       case SSH_OK:
-        return self.complete(ec);
+        return instrument.complete(sess, self, ec);
       case SSH_ERROR:
       {
         if (ei)
           ei->set_message(ssh_get_error(sess.native_handle()));
-        constexpr static boost::source_location loc = BOOST_CURRENT_LOCATION;
-        return self.complete(error_code(ssh_get_error_code(sess.native_handle()), ssh_category(), &loc));
+        ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+        return instrument.complete(sess, self, ec);
       }
       case SSH_AGAIN:
-        return sess.next_layer().async_wait(WaitType, std::move(self));
+        instrument.retried(sess);
+        instrument.waiting(sess, WaitType);
+        return detail::async_wait(sess, WaitType, std::move(self));
     }
   }
 };
@@ -106,12 +129,14 @@ struct async_wrap_session_async_call_1
 }
 }
 
-#define ASIOFY_LIBSSH_WRAP_FREE_SESSION_ASYNC_CALL_0(WaitType, Name)                                                  \
+#define ASIOFY_LIBSSH_WRAP_FREE_SESSION_ASYNC_CALL_0(WaitType, Kind, Name)                                            \
 template<typename Executor>                                                                                           \
 void Name(basic_session<Executor> & sess, error_code & ec, error_info & ei)                                           \
 {                                                                                                                     \
   ssh_set_blocking(sess.native_handle(), 1);                                                                          \
-  if (ssh_##Name(sess.native_handle()) != SSH_OK)                                                                     \
+  const int res = ssh_##Name(sess.native_handle());                                                                   \
+  ASIOFY_LIBSSH_TRACE_CALL(sess.id(), ::asiofy::libssh::op_kind::Kind, res, 0);                                       \
+  if (res != SSH_OK)                                                                                                  \
     ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, sess.native_handle())                                                          \
 }                                                                                                                     \
                                                                                                                       \
@@ -119,49 +144,53 @@ template<typename Executor>
 void Name(basic_session<Executor> & sess)                                                                             \
 {                                                                                                                     \
   ssh_set_blocking(sess.native_handle(), 1);                                                                          \
-  if (ssh_##Name(sess.native_handle()) != SSH_OK)                                                                     \
+  const int res = ssh_##Name(sess.native_handle());                                                                   \
+  ASIOFY_LIBSSH_TRACE_CALL(sess.id(), ::asiofy::libssh::op_kind::Kind, res, 0);                                       \
+  if (res != SSH_OK)                                                                                                  \
     ASIOFY_LIBSSH_THROW_ERROR(sess.native_handle())                                                                   \
 }                                                                                                                     \
                                                                                                                       \
 template <typename Executor,                                                                                          \
-    BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                   \
-      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                             \
-        BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                \
-async_handle_key_exchange(basic_session<Executor> & sess,                                                             \
-                          ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))                        \
+    ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                       \
+      ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                                 \
+        ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                    \
+async_##Name(basic_session<Executor> & sess,                                                                          \
+                          ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))                            \
 {                                                                                                                     \
   return net::async_compose<ConnectToken, void (error_code)>                                                          \
       (                                                                                                               \
           ::asiofy::libssh::detail::async_wrap_session_async_call_0<                                                  \
                   Executor, &ssh_##Name,                                                                              \
-                  net::socket_base::WaitType>{sess},                                                                  \
+                  net::socket_base::WaitType, ::asiofy::libssh::op_kind::Kind>{sess, nullptr},                        \
           token, sess                                                                                                 \
       );                                                                                                              \
 }                                                                                                                     \
                                                                                                                       \
 template <typename Executor,                                                                                          \
-    BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                   \
-      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                             \
-        BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                \
-async_handle_key_exchange(basic_session<Executor> & sess, error_info & ei,                                            \
-                          ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))                        \
+    ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                       \
+      ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                                 \
+        ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                    \
+async_##Name(basic_session<Executor> & sess, error_info & ei,                                                         \
+                          ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))                            \
 {                                                                                                                     \
   return net::async_compose<ConnectToken, void (error_code)>                                                          \
       (                                                                                                               \
           ::asiofy::libssh::detail::async_wrap_session_async_call_0<                                                  \
                   Executor, &ssh_##Name,                                                                              \
-                  net::socket_base::WaitType>{sess, &ei},                                                             \
+                  net::socket_base::WaitType, ::asiofy::libssh::op_kind::Kind>{sess, &ei},                            \
           token, sess                                                                                                 \
       );                                                                                                              \
 }                                                                                                                     \
 
 
-#define ASIOFY_LIBSSH_WRAP_FREE_SESSION_ASYNC_CALL_1(WaitType, Name, Arg0, ArgName)                                   \
+#define ASIOFY_LIBSSH_WRAP_FREE_SESSION_ASYNC_CALL_1(WaitType, Kind, Name, Arg0, ArgName)                             \
 template<typename Executor>                                                                                           \
 void Name(basic_session<Executor> & sess, Arg0 ArgName, error_code & ec, error_info & ei)                             \
 {                                                                                                                     \
   ssh_set_blocking(sess.native_handle(), 1);                                                                          \
-  if (ssh_##Name(sess.native_handle(), ArgName) != SSH_OK)                                                            \
+  const int res = ssh_##Name(sess.native_handle(), ArgName);                                                          \
+  ASIOFY_LIBSSH_TRACE_CALL(sess.id(), ::asiofy::libssh::op_kind::Kind, res, 0);                                       \
+  if (res != SSH_OK)                                                                                                  \
     ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, sess.native_handle())                                                          \
 }                                                                                                                     \
                                                                                                                       \
@@ -169,38 +198,40 @@ template<typename Executor>
 void Name(basic_session<Executor> & sess, Arg0 ArgName)                                                               \
 {                                                                                                                     \
   ssh_set_blocking(sess.native_handle(), 1);                                                                          \
-  if (ssh_##Name(sess.native_handle(), ArgName) != SSH_OK)                                                            \
+  const int res = ssh_##Name(sess.native_handle(), ArgName);                                                          \
+  ASIOFY_LIBSSH_TRACE_CALL(sess.id(), ::asiofy::libssh::op_kind::Kind, res, 0);                                       \
+  if (res != SSH_OK)                                                                                                  \
     ASIOFY_LIBSSH_THROW_ERROR(sess.native_handle())                                                                   \
 }                                                                                                                     \
                                                                                                                       \
 template <typename Executor,                                                                                          \
-    BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                   \
-      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                             \
-        BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                \
-async_handle_key_exchange(basic_session<Executor> & sess, Arg0 ArgName,                                               \
-                          ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))                        \
+    ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                       \
+      ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                                 \
+        ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                    \
+async_##Name(basic_session<Executor> & sess, Arg0 ArgName,                                                            \
+                          ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))                            \
 {                                                                                                                     \
   return net::async_compose<ConnectToken, void (error_code)>                                                          \
       (                                                                                                               \
           ::asiofy::libssh::detail::async_wrap_session_async_call_1<                                                  \
-                  Executor, &ssh_##Name,                                                                              \
-                  net::socket_base::WaitType>{sess, ArgName},                                                         \
+                  Executor, Arg0, &ssh_##Name,                                                                        \
+                  net::socket_base::WaitType, ::asiofy::libssh::op_kind::Kind>{sess, ArgName, nullptr},               \
           token, sess                                                                                                 \
       );                                                                                                              \
 }                                                                                                                     \
                                                                                                                       \
 template <typename Executor,                                                                                          \
-    BOOST_ASIO_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                   \
-      BOOST_ASIO_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                             \
-        BOOST_ASIO_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                \
-async_handle_key_exchange(basic_session<Executor> & sess, Arg0 ArgName, error_info & ei,                              \
-                          ConnectToken && token BOOST_ASIO_DEFAULT_COMPLETION_TOKEN(Executor))                        \
+    ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken                                                       \
+      ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>                                                                 \
+        ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))                                                    \
+async_##Name(basic_session<Executor> & sess, Arg0 ArgName, error_info & ei,                                           \
+                          ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))                            \
 {                                                                                                                     \
   return net::async_compose<ConnectToken, void (error_code)>                                                          \
       (                                                                                                               \
           ::asiofy::libssh::detail::async_wrap_session_async_call_1<                                                  \
-                  Executor, &ssh_##Name,                                                                              \
-                  net::socket_base::WaitType>{sess, ArgName &ei},                                                     \
+                  Executor, Arg0, &ssh_##Name,                                                                        \
+                  net::socket_base::WaitType, ::asiofy::libssh::op_kind::Kind>{sess, ArgName, &ei},                   \
           token, sess                                                                                                 \
       );                                                                                                              \
 }
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_DETAIL_MEMORY_HPP
+#define ASIOFY_LIBSSH_DETAIL_MEMORY_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/associated_allocator.hpp>
+#include <asio/handler_continuation_hook.hpp>
+#include <asio/version.hpp>
+#else
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/handler_continuation_hook.hpp>
+#include <boost/asio/version.hpp>
+#endif
+
+#if defined(ASIOFY_HAS_PMR)
+#include <memory_resource>
+#endif
+
+#include <memory>
+#include <utility>
+
+#if (defined(ASIO_VERSION) && ASIO_VERSION >= 101900) || (defined(BOOST_ASIO_VERSION) && BOOST_ASIO_VERSION >= 101900)
+#define ASIOFY_LIBSSH_HAS_CANCELLATION_SLOT 1
+#if defined(ASIOFY_STANDALONE)
+#include <asio/associated_cancellation_slot.hpp>
+#else
+#include <boost/asio/associated_cancellation_slot.hpp>
+#endif
+#endif
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+#if defined(ASIOFY_HAS_PMR)
+
+using session_allocator = std::pmr::polymorphic_allocator<char>;
+
+// A composed op, that allocates the intermediate operations from the memory resource of its session.
+template<typename Handler>
+struct resource_bound_handler
+{
+  Handler handler;
+  std::pmr::memory_resource * resource;
+
+  using allocator_type = session_allocator;
+  allocator_type get_allocator() const noexcept { return allocator_type(resource); }
+
+  using executor_type = decltype(std::declval<const Handler&>().get_executor());
+  executor_type get_executor() const noexcept { return handler.get_executor(); }
+
+#if defined(ASIOFY_LIBSSH_HAS_CANCELLATION_SLOT)
+  using cancellation_slot_type = net::associated_cancellation_slot_t<Handler>;
+  cancellation_slot_type get_cancellation_slot() const noexcept
+  {
+    return net::get_associated_cancellation_slot(handler);
+  }
+#endif
+
+  template<typename ... Args>
+  void operator()(Args && ... args)
+  {
+    handler(std::forward<Args>(args)...);
+  }
+
+  friend bool asio_handler_is_continuation(resource_bound_handler * h)
+  {
+    using net::asio_handler_is_continuation;
+    return asio_handler_is_continuation(std::addressof(h->handler));
+  }
+};
+
+#else
+
+using session_allocator = std::allocator<char>;
+
+#endif
+
+// Wait on the socket of the session, allocating from its memory resource if it has one.
+template<typename Session, typename WaitType, typename Handler>
+void async_wait(Session & sess, WaitType wait_type, Handler && handler)
+{
+#if defined(ASIOFY_HAS_PMR)
+  if (auto mr = sess.memory_resource())
+    return sess.next_layer().async_wait(
+        wait_type, resource_bound_handler<typename std::decay<Handler>::type>{std::forward<Handler>(handler), mr});
+#endif
+  sess.next_layer().async_wait(wait_type, std::forward<Handler>(handler));
+}
+
+}
+}
+}
+
+#endif //ASIOFY_LIBSSH_DETAIL_MEMORY_HPP
@@ -0,0 +1,240 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_DETAIL_PUMP_HPP
+#define ASIOFY_LIBSSH_DETAIL_PUMP_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/memory.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/bind_executor.hpp>
+#include <asio/coroutine.hpp>
+#include <asio/dispatch.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/post.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+#include <memory>
+#include <type_traits>
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+// the channel end of a pump: the data goes through stdout, an eof gets forwarded with send_eof.
+template<typename Executor>
+struct pump_channel
+{
+  using executor_type = Executor;
+
+  explicit pump_channel(basic_channel<Executor> & channel) : channel(channel), stream(channel.get_stdout()) {}
+
+  basic_channel<Executor> & channel;
+  typename basic_channel<Executor>::stdreader stream;
+
+  executor_type get_executor() { return channel.get_executor(); }
+
+  template<typename MutableBufferSequence, typename Handler>
+  void async_read_some(const MutableBufferSequence & buffers, Handler && handler)
+  {
+    stream.async_read_some(buffers, std::forward<Handler>(handler));
+  }
+
+  template<typename ConstBufferSequence, typename Handler>
+  void async_write_some(const ConstBufferSequence & buffers, Handler && handler)
+  {
+    stream.async_write_some(buffers, std::forward<Handler>(handler));
+  }
+};
+
+// what a pump holds of what it's given: a channel gets wrapped, any other stream is used as is.
+template<typename Stream>
+struct pump_end
+{
+  using type = Stream&;
+  static type make(Stream & stream) { return stream; }
+};
+
+template<typename Executor>
+struct pump_end<basic_channel<Executor>>
+{
+  using type = pump_channel<Executor>;
+  static type make(basic_channel<Executor> & channel) { return type{channel}; }
+};
+
+template<typename Stream>
+auto pump_shutdown_send(Stream & stream, int)
+    -> decltype(stream.shutdown(net::socket_base::shutdown_send, std::declval<error_code&>()), void())
+{
+  error_code ec;
+  stream.shutdown(net::socket_base::shutdown_send, ec);
+}
+
+template<typename Stream>
+void pump_shutdown_send(Stream &, long) {}
+
+// an eof shuts down the sending side of a stream, if it has a `shutdown` function.
+template<typename Stream, typename Handler>
+void pump_send_eof(Stream & stream, Handler && handler)
+{
+  pump_shutdown_send(stream, 0);
+  net::post(stream.get_executor(), [h = std::forward<Handler>(handler)]() mutable { h(error_code{}); });
+}
+
+template<typename Executor, typename Handler>
+void pump_send_eof(pump_channel<Executor> & end, Handler && handler)
+{
+  end.channel.async_send_eof(std::forward<Handler>(handler));
+}
+
+template<typename Stream>
+auto pump_close(Stream & stream, int)
+    -> decltype(stream.close(std::declval<error_code&>()), void())
+{
+  error_code ec;
+  stream.close(ec);
+}
+
+template<typename Stream>
+void pump_close(Stream &, long) {}
+
+template<typename Executor>
+void pump_close(pump_channel<Executor> & end, int)
+{
+  error_code ec;
+  error_info ei;
+  end.channel.close(ec, ei);
+}
+
+// Copies between two streams in both directions, until both sent eof or either failed.
+// `First` & `Second` are either held by value, e.g. a socket owned by the pump, or a reference.
+template<typename Executor, typename First, typename Second, typename Handler>
+struct pump_state
+{
+  using handler_executor_type = typename net::associated_executor<Handler, Executor>::type;
+
+  template<typename First1, typename Second1>
+  pump_state(const Executor & executor, const session_allocator & alloc, First1 && first, Second1 && second,
+             std::size_t buffer_size, Handler && handler)
+      : executor(executor), first(std::forward<First1>(first)), second(std::forward<Second1>(second)),
+        alloc(alloc), buffer_size(buffer_size), buffer(this->alloc.allocate(buffer_size * 2u)),
+        handler(std::move(handler)), work(net::get_associated_executor(this->handler, executor))
+  {
+  }
+
+  pump_state(const pump_state &) = delete;
+
+  ~pump_state()
+  {
+    alloc.deallocate(buffer, buffer_size * 2u);
+  }
+
+  Executor executor;
+  First first;
+  Second second;
+  session_allocator alloc;
+  std::size_t buffer_size;
+  // one allocation for both directions from the session's memory, that gets reused for the whole lifetime.
+  char * buffer;
+  Handler handler;
+  net::executor_work_guard<handler_executor_type> work;
+
+  int pending = 2;
+  error_code error;
+
+  net::mutable_buffer buffer_of(bool from_first)
+  {
+    return net::buffer(buffer + (from_first ? 0u : buffer_size), buffer_size);
+  }
+
+  // both directions complete on `executor`, so no synchronization needed.
+  void done(error_code ec)
+  {
+    if (ec && !error)
+    {
+      error = ec;
+      // make the other direction finish.
+      pump_close(first, 0);
+      pump_close(second, 0);
+    }
+
+    if (--pending == 0)
+    {
+      auto ex = work.get_executor();
+      work.reset();
+      net::dispatch(ex, [h = std::move(handler), ec = error]() mutable { h(ec); });
+    }
+  }
+};
+
+// one direction of a pump, with its half of the buffer.
+template<typename State, bool FromFirst>
+struct pump_op : net::coroutine
+{
+  std::shared_ptr<State> st;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {}, std::size_t n = 0u)
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      for (;;)
+      {
+        ASIOFY_CORO_YIELD source().async_read_some(st->buffer_of(FromFirst), std::move(self));
+        if (ec == net::error::eof)
+        {
+          ASIOFY_CORO_YIELD pump_send_eof(sink(), std::move(self));
+          return self.complete(ec);
+        }
+        if (ec)
+          return self.complete(ec);
+
+        // a channel write only sends as much as the window allows, async_write takes care of the rest.
+        ASIOFY_CORO_YIELD net::async_write(sink(), net::buffer(st->buffer_of(FromFirst), n), std::move(self));
+        if (ec)
+          return self.complete(ec);
+      }
+    }
+  }
+
+ private:
+  auto & source() { return end(std::integral_constant<bool,  FromFirst>{}); }
+  auto & sink()   { return end(std::integral_constant<bool, !FromFirst>{}); }
+
+  auto & end(std::true_type)  { return st->first; }
+  auto & end(std::false_type) { return st->second; }
+};
+
+template<typename State>
+void start_pump(const std::shared_ptr<State> & st)
+{
+  auto on_first  = net::bind_executor(st->executor, [st](error_code ec){ st->done(ec);});
+  auto on_second = net::bind_executor(st->executor, [st](error_code ec){ st->done(ec);});
+  net::async_compose<decltype(on_first), void(error_code)>(
+      pump_op<State, true>{{}, st}, on_first, st->first, st->second);
+  net::async_compose<decltype(on_second), void(error_code)>(
+      pump_op<State, false>{{}, st}, on_second, st->first, st->second);
+}
+
+}
+}
+}
+
+#endif //ASIOFY_LIBSSH_DETAIL_PUMP_HPP
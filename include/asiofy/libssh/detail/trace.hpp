@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_DETAIL_TRACE_HPP
+#define ASIOFY_LIBSSH_DETAIL_TRACE_HPP
+
+// Static tracepoints (USDT) where asiofy calls into libssh & where it waits on the socket,
+// compiled in if ASIOFY_LIBSSH_ENABLE_USDT is defined. They're a nop until attached, e.g.
+//
+//   bpftrace -e 'usdt:./server:asiofy_libssh:call { @[arg1, arg2] = count(); }'
+//
+// call: session id, op_kind, return code of libssh, bytes read or written
+// wait: session id, op_kind, asio's wait_type (0 read, 1 write, 2 error)
+//
+// Without it the arguments are only used in `sizeof`, so they're never evaluated.
+
+#if defined(ASIOFY_LIBSSH_ENABLE_USDT)
+
+#include <sys/sdt.h>
+
+#define ASIOFY_LIBSSH_TRACE_CALL(SessionId, Kind, Result, Bytes)                                                     \
+  DTRACE_PROBE4(asiofy_libssh, call, static_cast<unsigned long long>(SessionId), static_cast<int>(Kind),             \
+                static_cast<int>(Result), static_cast<long long>(Bytes))
+
+#define ASIOFY_LIBSSH_TRACE_WAIT(SessionId, Kind, WaitType)                                                          \
+  DTRACE_PROBE3(asiofy_libssh, wait, static_cast<unsigned long long>(SessionId), static_cast<int>(Kind),             \
+                static_cast<int>(WaitType))
+
+#else
+
+#define ASIOFY_LIBSSH_TRACE_CALL(SessionId, Kind, Result, Bytes)                                                     \
+  static_cast<void>(sizeof(SessionId) + sizeof(Kind) + sizeof(Result) + sizeof(Bytes))
+#define ASIOFY_LIBSSH_TRACE_WAIT(SessionId, Kind, WaitType)                                                          \
+  static_cast<void>(sizeof(SessionId) + sizeof(Kind) + sizeof(WaitType))
+
+#endif
+
+#endif //ASIOFY_LIBSSH_DETAIL_TRACE_HPP
@@ -11,9 +11,16 @@
 #include <libssh/libssh.h>
 #include <asiofy/libssh/error.hpp>
 #include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/memory.hpp>
+#include <asiofy/libssh/stats.hpp>
 
+#if defined(ASIOFY_STANDALONE)
+#include <asio/compose.hpp>
+#include <asio/socket_base.hpp>
+#else
 #include <boost/asio/compose.hpp>
 #include <boost/asio/socket_base.hpp>
+#endif
 
 namespace asiofy
 {
@@ -26,45 +33,58 @@ struct basic_session;
 namespace detail
 {
 
+// InitialWaitType is used for calls that need to send something before a reply can be read,
+// e.g. channel requests. Waiting for write readiness completes immediately in those cases.
 template<typename Executor,
          typename Func,
-         net::socket_base::wait_type WaitType = net::socket_base::wait_read>
+         net::socket_base::wait_type WaitType = net::socket_base::wait_read,
+         net::socket_base::wait_type InitialWaitType = WaitType,
+         op_kind Kind = op_kind::other>
 struct async_session_op_t
 {
   basic_session<Executor> & sess;
   Func func;
   error_info * ei;
+  op_instrument<Kind> instrument = {};
+
   template<typename Self>
   void operator()(Self && self)
   {
+    instrument.initiated(sess);
     ssh_set_blocking(sess.native_handle(), 0);
-    sess.next_layer().async_wait(WaitType, std::move(self));
+    instrument.waiting(sess, InitialWaitType);
+    detail::async_wait(sess, InitialWaitType, std::move(self));
   }
 
   template<typename Self>
   void operator()(Self && self, error_code ec)
   {
+    instrument.woken(sess);
     if (ec)
-      return self.complete(ec);
-    int res = func(sess.native_handle());
+      return instrument.complete(sess, self, ec);
+    int res = instrument.call(sess, [&]{ return func(sess.native_handle()); });
     switch(res)
     {
       case SSH_OK:
-        return self.complete(ec);
+        return instrument.complete(sess, self, ec);
       case SSH_ERROR:
       {
         if (ei)
           ei->set_message(ssh_get_error(sess.native_handle()));
-        constexpr static boost::source_location loc = BOOST_CURRENT_LOCATION;
-        return self.complete(error_code(ssh_get_error_code(sess.native_handle()), ssh_category(), &loc));
+        ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+        return instrument.complete(sess, self, ec);
       }
       case SSH_AGAIN:
-        return sess.next_layer().async_wait(WaitType, std::move(self));
+        instrument.retried(sess);
+        instrument.waiting(sess, WaitType);
+        return detail::async_wait(sess, WaitType, std::move(self));
     }
   }
 };
 
 template<net::socket_base::wait_type WaitType = net::socket_base::wait_read ,
+         net::socket_base::wait_type InitialWaitType = WaitType,
+         op_kind Kind = op_kind::other,
          typename Executor, typename Func,
          ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) CompletionToken ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
 ASIOFY_INITFN_RESULT_TYPE(CompletionToken, void (error_code))
@@ -73,11 +93,91 @@ async_session_op(basic_session<Executor> & sess, Func && func,
 {
   return net::async_compose<CompletionToken, void (error_code)>
       (
-          detail::async_session_op_t<Executor, typename std::decay<Func>::type, WaitType>{
+          detail::async_session_op_t<Executor, typename std::decay<Func>::type, WaitType, InitialWaitType, Kind>{
             sess, std::forward<Func>(func), ei}, token, sess
       );
 }
 
+// An async_session_op on a channel, which takes the channel's id for the slow-op log.
+template<net::socket_base::wait_type WaitType = net::socket_base::wait_read ,
+         net::socket_base::wait_type InitialWaitType = WaitType,
+         op_kind Kind = op_kind::other,
+         typename Executor, typename Func,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) CompletionToken ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(CompletionToken, void (error_code))
+async_channel_op(basic_session<Executor> & sess, std::uint64_t channel_id, Func && func,
+                 error_info * ei, CompletionToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<CompletionToken, void (error_code)>
+      (
+          detail::async_session_op_t<Executor, typename std::decay<Func>::type, WaitType, InitialWaitType, Kind>{
+            sess, std::forward<Func>(func), ei, channel_id}, token, sess
+      );
+}
+
+// The userauth functions use their own set of return codes.
+template<typename Executor, typename Func>
+struct async_auth_op_t
+{
+  basic_session<Executor> & sess;
+  Func func;
+  error_info * ei;
+  op_instrument<op_kind::auth> instrument = {};
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    instrument.initiated(sess);
+    ssh_set_blocking(sess.native_handle(), 0);
+    instrument.waiting(sess, net::socket_base::wait_write);
+    detail::async_wait(sess, net::socket_base::wait_write, std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    instrument.woken(sess);
+    if (ec)
+      return instrument.complete(sess, self, ec);
+    int res = instrument.call(sess, [&]{ return func(sess.native_handle()); });
+    switch(res)
+    {
+      case SSH_AUTH_SUCCESS:
+        return instrument.complete(sess, self, ec);
+      case SSH_AUTH_DENIED:
+        ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::auth_denied), asiofy_category());
+        return instrument.complete(sess, self, ec);
+      case SSH_AUTH_PARTIAL:
+        ASIOFY_ASSIGN_EC(ec, static_cast<int>(errc::auth_partial), asiofy_category());
+        return instrument.complete(sess, self, ec);
+      case SSH_AUTH_AGAIN:
+        instrument.retried(sess);
+        instrument.waiting(sess, net::socket_base::wait_read);
+        return detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+      case SSH_AUTH_ERROR:
+      default:
+      {
+        if (ei)
+          ei->set_message(ssh_get_error(sess.native_handle()));
+        ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+        return instrument.complete(sess, self, ec);
+      }
+    }
+  }
+};
+
+template<typename Executor, typename Func,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) CompletionToken ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(CompletionToken, void (error_code))
+async_auth_op(basic_session<Executor> & sess, Func && func,
+              error_info * ei, CompletionToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<CompletionToken, void (error_code)>
+      (
+          detail::async_auth_op_t<Executor, typename std::decay<Func>::type>{
+            sess, std::forward<Func>(func), ei}, token, sess
+      );
+}
 
 template<typename Func, typename ... Args>
 auto bind_back(Func && func, Args ... args)
@@ -8,26 +8,40 @@
 #ifndef ASIOFY_LIBSSH_ERROR_HPP
 #define ASIOFY_LIBSSH_ERROR_HPP
 
-#include <boost/system/error_category.hpp>
-#include <boost/system/error_code.hpp>
-#include <boost/system/system_error.hpp>
+#include <asiofy/detail/config.hpp>
 
 namespace asiofy
 {
 namespace libssh
 {
 
-/// The type of error code used by the library \ingroup reference
-using error_code = boost::system::error_code;
+/// The type of error code used by the library, std::error_code with ASIOFY_STANDALONE \ingroup reference
+using error_code = ::asiofy::error_code;
 
 /// The type of system error thrown by the library \ingroup reference
-using system_error = boost::system::system_error;
+using system_error = ::asiofy::system_error;
 
 /// The type of error category used by the library \ingroup reference
-using error_category = boost::system::error_category;
+using error_category = ::asiofy::error_category;
 
 
-error_category & ssh_category();
+ASIOFY_DECL error_category & ssh_category();
+
+/// Error conditions detected by asiofy itself, that libssh reports through return values only.
+enum class errc
+{
+  auth_denied = 1,
+  auth_partial,
+  host_key_unknown,
+  host_key_changed,
+};
+
+ASIOFY_DECL error_category & asiofy_category();
+
+inline error_code make_error_code(errc e)
+{
+  return error_code(static_cast<int>(e), asiofy_category());
+}
 
 
 // copy-pastaed from anarthal/mysql --> alias ?
@@ -64,7 +78,34 @@ class error_info
 }
 
 
-#if defined(BOOST_SQLITE_HEADER_ONLY)
+#if defined(ASIOFY_STANDALONE)
+namespace std
+{
+
+template<>
+struct is_error_code_enum<::asiofy::libssh::errc>
+{
+  static const bool value = true;
+};
+
+}
+#else
+namespace boost
+{
+namespace system
+{
+
+template<>
+struct is_error_code_enum<::asiofy::libssh::errc>
+{
+  static const bool value = true;
+};
+
+}
+}
+#endif
+
+#if defined(ASIOFY_HEADER_ONLY)
 #include <asiofy/libssh/impl/error.ipp>
 #endif
 
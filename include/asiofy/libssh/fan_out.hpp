@@ -0,0 +1,339 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_FAN_OUT_HPP
+#define ASIOFY_LIBSSH_FAN_OUT_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/connect.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/coroutine.hpp>
+#include <asio/dispatch.hpp>
+#include <asio/executor_work_guard.hpp>
+#include <asio/post.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#else
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// A host to run a command on.
+struct exec_target
+{
+  std::string host;
+  unsigned short port = 22u;
+  std::string user;
+};
+
+struct exec_fan_out_options
+{
+  /// The maximum number of sessions in flight.
+  std::size_t max_in_flight = 64u;
+  /// The deadline for every host, covering everything from resolving to the exit status.
+  std::chrono::steady_clock::duration deadline = std::chrono::seconds(30);
+  /// The size of the read buffer of every in-flight session.
+  std::size_t buffer_size = 16384u;
+  /// Gets applied to every session before it connects, e.g. to set SSH_OPTIONS_KNOWNHOSTS or add an identity.
+  /** It gets invoked from the strands of the hosts concurrently, like `on_exit`. */
+  std::function<void(ssh_session)> configure;
+};
+
+namespace detail
+{
+
+template<typename Executor, typename Handler, typename OutputHandler, typename ExitHandler>
+struct exec_fan_out_state
+{
+  using handler_executor_type = typename net::associated_executor<Handler, Executor>::type;
+
+  exec_fan_out_state(Handler && handler, const Executor & executor,
+                     std::vector<exec_target> && targets, std::string && command,
+                     const exec_fan_out_options & options,
+                     OutputHandler && on_output, ExitHandler && on_exit)
+      : handler(std::move(handler)),
+        work(net::get_associated_executor(this->handler, executor)),
+        executor(executor), targets(std::move(targets)), command(std::move(command)), options(options),
+        on_output(std::move(on_output)), on_exit(std::move(on_exit))
+  {
+  }
+
+  Handler handler;
+  net::executor_work_guard<handler_executor_type> work;
+  Executor executor;
+  std::vector<exec_target> targets;
+  std::string command;
+  exec_fan_out_options options;
+  OutputHandler on_output;
+  ExitHandler on_exit;
+
+  std::atomic<std::size_t> next{0u};
+  std::atomic<std::size_t> lanes{0u};
+
+  void lane_done()
+  {
+    if (--lanes == 0u)
+      complete();
+  }
+
+  void complete()
+  {
+    auto ex = work.get_executor();
+    work.reset();
+    net::dispatch(ex, [h = std::move(handler)]() mutable { h(error_code{}); });
+  }
+};
+
+// everything of one host lives on the strand of its lane.
+template<typename Executor>
+struct exec_fan_out_host
+{
+  using resolver_type = net::ip::basic_resolver<net::ip::tcp, Executor>;
+
+  explicit exec_fan_out_host(const Executor & executor)
+      : resolver(executor), session(executor), timer(executor)
+  {
+  }
+
+  resolver_type resolver;
+  basic_session<Executor> session;
+  optional<basic_channel<Executor>> channel;
+  net::basic_waitable_timer<std::chrono::steady_clock, net::wait_traits<std::chrono::steady_clock>, Executor> timer;
+  bool timed_out = false;
+};
+
+// A lane handles one host after the other, so the number of lanes is the number of sessions in flight.
+template<typename State>
+struct exec_fan_out_lane : net::coroutine
+{
+  using executor_type = net::strand<decltype(std::declval<State&>().executor)>;
+  using host_type = exec_fan_out_host<executor_type>;
+  using resolver_results = typename host_type::resolver_type::results_type;
+
+  std::shared_ptr<State> state;
+  executor_type executor;
+  std::unique_ptr<char[]> buffer;
+  std::shared_ptr<host_type> host;
+  std::size_t index = 0u;
+  int exit_status = -1;
+
+  exec_fan_out_lane(std::shared_ptr<State> state)
+      : state(std::move(state)), executor(net::make_strand(this->state->executor)),
+        buffer(new char[this->state->options.buffer_size])
+  {
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec, resolver_results results)
+  {
+    if (!ec && !host->timed_out)
+    {
+      sess().options_set(SSH_OPTIONS_HOST, state->targets[index].host.c_str());
+      if (state->options.configure)
+        state->options.configure(sess().native_handle());
+      std::vector<net::generic::stream_protocol::endpoint> eps;
+      for (const auto & entry : results)
+        eps.emplace_back(entry.endpoint());
+      return async_connect(sess(), std::move(eps), state->targets[index].user, std::move(self));
+    }
+    (*this)(std::move(self), ec);
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec, int status)
+  {
+    exit_status = status;
+    (*this)(std::move(self), ec);
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      while ((index = state->next++) < state->targets.size())
+      {
+        start_host();
+        ASIOFY_CORO_YIELD host->resolver.async_resolve(
+            state->targets[index].host, std::to_string(state->targets[index].port), std::move(self));
+
+        if (!check(ec))
+        {
+          host->channel.emplace(sess());
+          ASIOFY_CORO_YIELD host->channel->async_open_session(std::move(self));
+        }
+        if (!check(ec))
+        {
+          ASIOFY_CORO_YIELD host->channel->async_request_exec(state->command.c_str(), std::move(self));
+        }
+
+        while (!check(ec) && !drain(ec))
+        {
+          ASIOFY_CORO_YIELD detail::async_wait(sess(), net::socket_base::wait_read, std::move(self));
+        }
+
+        if (!check(ec))
+        {
+          ASIOFY_CORO_YIELD host->channel->async_exit_status(std::move(self));
+        }
+        check(ec);
+        finish_host(ec);
+      }
+      host.reset();
+      self.complete();
+    }
+  }
+
+ private:
+  basic_session<executor_type> & sess() { return host->session; }
+
+  void start_host()
+  {
+    exit_status = -1;
+    host = std::make_shared<host_type>(executor);
+    host->timer.expires_after(state->options.deadline);
+    host->timer.async_wait(
+        [h = host](error_code ec)
+        {
+          if (ec)
+            return;
+          h->timed_out = true;
+          h->resolver.cancel();
+          // closes the socket, unless libssh has it already. Either way its waits get cancelled.
+          error_code ig;
+          h->session.next_layer().drop(ig);
+        });
+  }
+
+  // ops started after the timer fired won't be cancelled by it, so every step checks the flag.
+  bool check(error_code & ec)
+  {
+    if (host->timed_out)
+      ASIOFY_ASSIGN_EC(ec, net::error::timed_out, net::error::get_system_category())
+    return !!ec;
+  }
+
+  // read stdout & stderr until libssh has no more data, so a full stderr can't block the window.
+  // returns true when the remote sent eof.
+  bool drain(error_code & ec)
+  {
+    const auto ch = host->channel->native_handle();
+    const auto size = clamp_size(state->options.buffer_size);
+    for (int is_stderr = 0; is_stderr < 2; is_stderr++)
+    {
+      int res;
+      while ((res = ssh_channel_read_nonblocking(ch, buffer.get(), size, is_stderr)) > 0)
+        state->on_output(index, is_stderr != 0, net::const_buffer(buffer.get(), static_cast<std::size_t>(res)));
+
+      if (res == SSH_ERROR)
+      {
+        ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess().native_handle()), ssh_category())
+        return true;
+      }
+    }
+    return ssh_channel_is_eof(ch) != 0;
+  }
+
+  void finish_host(error_code ec)
+  {
+    error_code ig;
+    host->timer.cancel(ig);
+    state->on_exit(index, ec, exit_status);
+    host->channel.reset();
+    // closes the descriptor of a host that never got to the key exchange, too.
+    sess().disconnect();
+  }
+};
+
+template<typename Executor>
+struct initiate_exec_fan_out
+{
+  Executor executor;
+
+  template<typename Handler, typename OutputHandler, typename ExitHandler>
+  void operator()(Handler && handler,
+                  std::vector<exec_target> targets, std::string command,
+                  const exec_fan_out_options & options,
+                  OutputHandler && on_output, ExitHandler && on_exit)
+  {
+    using state_type = exec_fan_out_state<Executor,
+                                          typename std::decay<Handler>::type,
+                                          typename std::decay<OutputHandler>::type,
+                                          typename std::decay<ExitHandler>::type>;
+    const auto lanes = (std::min)((std::max)(options.max_in_flight, std::size_t(1u)), targets.size());
+    auto st = std::make_shared<state_type>(
+        std::forward<Handler>(handler), executor, std::move(targets), std::move(command), options,
+        std::forward<OutputHandler>(on_output), std::forward<ExitHandler>(on_exit));
+
+    if (lanes == 0u)
+      return net::post(executor, [st]{ st->complete();});
+
+    st->lanes = lanes;
+    for (std::size_t i = 0u; i < lanes; i++)
+    {
+      exec_fan_out_lane<state_type> lane{st};
+      auto ex = lane.executor;
+      auto on_done = [st]{ st->lane_done(); };
+      net::async_compose<decltype(on_done), void()>(std::move(lane), on_done, ex);
+    }
+  }
+};
+
+}
+
+/// Run `command` on every host in `targets`, keeping at most `options.max_in_flight` sessions open.
+/** Every host gets its own strand, so the throughput scales with the number of threads running the executor.
+ *
+ * `on_output` gets invoked with `(std::size_t index, bool is_stderr, net::const_buffer data)` for any output,
+ * `on_exit` with `(std::size_t index, error_code ec, int exit_status)` once a host is done.
+ * The index refers to `targets` and both get invoked from the strands concurrently,
+ * i.e. they need to be thread-safe if the executor runs on multiple threads.
+ *
+ * The token completes once all hosts are done, errors are only reported to `on_exit`.
+ * Hosts are authenticated through publickey auto and verified against known_hosts.
+ */
+template<typename Executor, typename OutputHandler, typename ExitHandler,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) CompletionToken
+            ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(CompletionToken, void (error_code))
+async_exec_fan_out(const Executor & executor,
+                   std::vector<exec_target> targets, std::string command,
+                   const exec_fan_out_options & options,
+                   OutputHandler && on_output, ExitHandler && on_exit,
+                   CompletionToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_initiate<CompletionToken, void(error_code)>(
+      detail::initiate_exec_fan_out<Executor>{executor}, token,
+      std::move(targets), std::move(command), options,
+      std::forward<OutputHandler>(on_output), std::forward<ExitHandler>(on_exit));
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_FAN_OUT_HPP
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_FORWARD_HPP
+#define ASIOFY_LIBSSH_FORWARD_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/bridge.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/basic_socket_acceptor.hpp>
+#include <asio/basic_stream_socket.hpp>
+#include <asio/coroutine.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+#else
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/basic_stream_socket.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#endif
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+struct forward_options
+{
+  /// The buffer size of each direction of a forwarded connection.
+  std::size_t buffer_size = 8192u;
+  /// Connections accepted beyond this get closed right away.
+  std::size_t max_connections = 8192u;
+  /// After an accept error like running out of file descriptors, accepting resumes after this delay.
+  std::chrono::steady_clock::duration accept_retry_delay = std::chrono::milliseconds(100);
+};
+
+namespace detail
+{
+
+template<typename Executor>
+struct forward_state
+{
+  basic_session<Executor> & sess;
+  // for a reverse forward, this is the address the client requested to listen on.
+  std::string remote_host;
+  int remote_port;
+  forward_options options;
+  bool reverse = false;
+  std::size_t connections = 0u;
+};
+
+template<typename Executor>
+struct forward_connection
+{
+  using socket_type = net::basic_stream_socket<net::ip::tcp, Executor>;
+
+  forward_connection(socket_type && socket, basic_session<Executor> & sess)
+      : socket(std::move(socket)), channel(sess)
+  {
+    error_code ec;
+    auto ep = this->socket.remote_endpoint(ec);
+    if (!ec)
+    {
+      source_host = ep.address().to_string(ec);
+      source_port = ep.port();
+    }
+  }
+
+  socket_type socket;
+  basic_channel<Executor> channel;
+  std::string source_host{"127.0.0.1"};
+  int source_port = 0;
+};
+
+template<typename Executor>
+struct forward_connection_op : net::coroutine
+{
+  using connection_type = forward_connection<Executor>;
+
+  std::shared_ptr<forward_state<Executor>> state;
+  std::unique_ptr<connection_type> conn;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      if (state->reverse)
+      {
+        ASIOFY_CORO_YIELD conn->channel.async_open_reverse_forward(
+            state->remote_host.c_str(), state->remote_port,
+            conn->source_host.c_str(), conn->source_port, std::move(self));
+      }
+      else
+      {
+        ASIOFY_CORO_YIELD conn->channel.async_open_forward(
+            state->remote_host.c_str(), state->remote_port,
+            conn->source_host.c_str(), conn->source_port, std::move(self));
+      }
+
+      if (!ec)
+      {
+        ASIOFY_CORO_YIELD async_bridge(conn->channel, conn->socket, state->options.buffer_size, std::move(self));
+      }
+
+      {
+        error_code ig;
+        error_info ei;
+        conn->socket.close(ig);
+        if (conn->channel.is_open())
+          conn->channel.close(ig, ei);
+      }
+      state->connections--;
+      self.complete(ec);
+    }
+  }
+};
+
+// ConnectionOp gets launched for every accepted connection, with a state & a `ConnectionOp::connection_type`.
+template<typename Executor, typename ConnectionOp = forward_connection_op<Executor>>
+struct forward_accept_op : net::coroutine
+{
+  using acceptor_type   = net::basic_socket_acceptor<net::ip::tcp, Executor>;
+  using socket_type     = typename forward_connection<Executor>::socket_type;
+  using connection_type = typename ConnectionOp::connection_type;
+  using timer_type      = net::basic_waitable_timer<std::chrono::steady_clock,
+                                                    net::wait_traits<std::chrono::steady_clock>,
+                                                    Executor>;
+
+  acceptor_type & acceptor;
+  std::shared_ptr<forward_state<Executor>> state;
+  std::unique_ptr<timer_type> retry_timer;
+
+  template<typename Self, typename Socket>
+  void operator()(Self && self, error_code ec, Socket socket)
+  {
+    if (!ec)
+      accepted(socket_type(std::move(socket)));
+    (*this)(std::move(self), ec);
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      for (;;)
+      {
+        ASIOFY_CORO_YIELD acceptor.async_accept(std::move(self));
+        if (!ec || ec == net::error::connection_aborted)
+          continue;
+        // only closing or cancelling the acceptor ends the forward.
+        if (ec == net::error::operation_aborted || !acceptor.is_open())
+          break;
+
+        // e.g. EMFILE, which would fail again right away, so give open connections some time to finish.
+        if (!retry_timer)
+          retry_timer = std::make_unique<timer_type>(acceptor.get_executor());
+        retry_timer->expires_after(state->options.accept_retry_delay);
+        ASIOFY_CORO_YIELD retry_timer->async_wait(std::move(self));
+      }
+      self.complete(ec);
+    }
+  }
+
+ private:
+  void accepted(socket_type && socket)
+  {
+    if (state->connections >= state->options.max_connections)
+    {
+      error_code ig;
+      socket.close(ig);
+      return;
+    }
+
+    state->connections++;
+    auto conn = std::make_unique<connection_type>(std::move(socket), state->sess);
+    // errors of single connections only close that connection.
+    auto on_done = [](error_code) {};
+    net::async_compose<decltype(on_done), void(error_code)>(
+        ConnectionOp{{}, state, std::move(conn)},
+        on_done, state->sess.next_layer());
+  }
+};
+
+}
+
+/// Accept connections on `acceptor` and forward each one through a direct-tcpip channel to `remote_host:remote_port`.
+/** This is the equivalent of `ssh -L`. All channels share `sess`, which needs to be authenticated.
+ * The acceptor must use the same executor as the session, since libssh is not thread-safe.
+ *
+ * Every connection costs one socket, one channel and two buffers of `options.buffer_size`.
+ * The token completes once the acceptor got closed or cancelled, other accept errors are retried;
+ * connections that are already open keep forwarding until either side closes.
+ */
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ForwardToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ForwardToken, void (error_code))
+async_forward_local(basic_session<Executor> & sess,
+                    net::basic_socket_acceptor<net::ip::tcp, Executor> & acceptor,
+                    std::string remote_host, int remote_port,
+                    const forward_options & options,
+                    ForwardToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  auto state = std::allocate_shared<detail::forward_state<Executor>>(
+      sess.get_allocator(), detail::forward_state<Executor>{sess, std::move(remote_host), remote_port, options, false});
+  return net::async_compose<ForwardToken, void (error_code)>(
+      detail::forward_accept_op<Executor>{{}, acceptor, std::move(state), nullptr},
+      token, acceptor);
+}
+
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ForwardToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ForwardToken, void (error_code))
+async_forward_local(basic_session<Executor> & sess,
+                    net::basic_socket_acceptor<net::ip::tcp, Executor> & acceptor,
+                    std::string remote_host, int remote_port,
+                    ForwardToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return async_forward_local(sess, acceptor, std::move(remote_host), remote_port,
+                             forward_options{}, std::forward<ForwardToken>(token));
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_FORWARD_HPP
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_HANDLE_POOL_HPP
+#define ASIOFY_LIBSSH_HANDLE_POOL_HPP
+
+#include <libssh/libssh.h>
+#include <libssh/callbacks.h>
+#include <libssh/server.h>
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+class session_handle_pool;
+
+namespace detail
+{
+
+// frees the session, or gives it back to the pool it came from.
+struct session_deleter
+{
+  session_handle_pool * pool = nullptr;
+  inline void operator()(ssh_session sess) const;
+};
+
+}
+
+/// An owning handle of a session, which might be taken from a `session_handle_pool`.
+using session_handle = std::unique_ptr<typename std::remove_pointer<ssh_session>::type, detail::session_deleter>;
+
+/// A pool of sessions to reuse, instead of calling `ssh_new` & `ssh_free` for every connection.
+/** A session given back gets disconnected, which closes its socket & resets its state,
+ * but keeps its allocation & buffers. Its callbacks are cleared.
+ *
+ * libssh can't reset options, so every option set on a session survives its reuse,
+ * e.g. the host, user & identities of the last connection. A pool built with an `option_set`
+ * applies it to every session it hands out, so options that set covers start out the same for
+ * new & reused sessions. Any other option a connection sets is still seen by the next one,
+ * so either have the set cover all of them, or only pool sessions configured alike, e.g. the ones accepted by one bind.
+ *
+ * It can be shared between threads. The pool must outlive all handles taken from it.
+ */
+class session_handle_pool
+{
+ public:
+  /// @param max_idle The number of sessions kept, any returned beyond that get freed.
+  explicit session_handle_pool(std::size_t max_idle = 64u) : max_idle_(max_idle)
+  {
+  }
+
+  /// @param options Applied to every session on `acquire`, new or reused.
+  /// @param max_idle The number of sessions kept, any returned beyond that get freed.
+  template<typename ... Options>
+  explicit session_handle_pool(const option_set<Options...> & options, std::size_t max_idle = 64u)
+      : max_idle_(max_idle), configure_([options](ssh_session sess) { return options.apply(sess); })
+  {
+  }
+
+  session_handle_pool(const session_handle_pool &) = delete;
+  session_handle_pool& operator=(const session_handle_pool &) = delete;
+
+  ~session_handle_pool()
+  {
+    for (auto sess : idle_)
+      ssh_free(sess);
+  }
+
+  /// Take a session from the pool, or create one if it's empty.
+  /** Returns an empty handle if libssh can't create a session or rejects the options of the pool. */
+  session_handle acquire()
+  {
+    ssh_session sess = nullptr;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (!idle_.empty())
+      {
+        sess = idle_.back();
+        idle_.pop_back();
+      }
+    }
+    if (sess != nullptr)
+      reused_.fetch_add(1u, std::memory_order_relaxed);
+    else
+    {
+      sess = ssh_new();
+      created_.fetch_add(1u, std::memory_order_relaxed);
+    }
+    if (sess != nullptr && configure_ && !configure_(sess))
+    {
+      ssh_free(sess);
+      sess = nullptr;
+    }
+    return session_handle{sess, detail::session_deleter{this}};
+  }
+
+  /// Create sessions up front, so the first `n` acquires don't allocate.
+  void reserve(std::size_t n)
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    idle_.reserve(max_idle_);
+    while (idle_.size() < (std::min)(n, max_idle_))
+    {
+      idle_.push_back(ssh_new());
+      created_.fetch_add(1u, std::memory_order_relaxed);
+    }
+  }
+
+  /// The number of sessions waiting to be reused.
+  std::size_t idle() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return idle_.size();
+  }
+
+  /// The number of sessions created by `ssh_new`.
+  std::uint64_t created() const { return created_.load(std::memory_order_relaxed); }
+  /// The number of acquires served from the pool.
+  std::uint64_t reused()  const { return reused_.load(std::memory_order_relaxed); }
+
+ private:
+  friend struct detail::session_deleter;
+
+  void release(ssh_session sess)
+  {
+    reset(sess);
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (idle_.size() < max_idle_)
+      {
+        idle_.push_back(sess);
+        return;
+      }
+    }
+    ssh_free(sess);
+  }
+
+  static void reset(ssh_session sess)
+  {
+    static ssh_callbacks_struct no_callbacks = []{ ssh_callbacks_struct cb{}; ssh_callbacks_init(&cb); return cb; }();
+    static ssh_server_callbacks_struct no_server_callbacks =
+        []{ ssh_server_callbacks_struct cb{}; ssh_callbacks_init(&cb); return cb; }();
+
+    // libssh documents a disconnected session as reusable.
+    ssh_disconnect(sess);
+    ssh_set_callbacks(sess, &no_callbacks);
+    ssh_set_server_callbacks(sess, &no_server_callbacks);
+    ssh_set_message_callback(sess, nullptr, nullptr);
+  }
+
+  const std::size_t max_idle_;
+  const std::function<bool(ssh_session)> configure_;
+  mutable std::mutex mutex_;
+  std::vector<ssh_session> idle_;
+  std::atomic<std::uint64_t> created_{0u}, reused_{0u};
+};
+
+void detail::session_deleter::operator()(ssh_session sess) const
+{
+  if (pool != nullptr)
+    pool->release(sess);
+  else
+    ssh_free(sess);
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_HANDLE_POOL_HPP
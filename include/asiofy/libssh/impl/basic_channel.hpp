@@ -0,0 +1,670 @@
+//
+// Copyright (c) 2022 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_IMPL_BASIC_CHANNEL_HPP
+#define ASIOFY_LIBSSH_IMPL_BASIC_CHANNEL_HPP
+
+#include <asiofy/libssh/basic_channel.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/buffer.hpp>
+#include <asio/error.hpp>
+#include <asio/post.hpp>
+#else
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+namespace detail
+{
+
+template<typename Buffer, typename BufferSequence>
+Buffer first_buffer(const BufferSequence & buffers)
+{
+  auto itr = net::buffer_sequence_begin(buffers);
+  const auto end = net::buffer_sequence_end(buffers);
+  for (; itr != end; ++itr)
+  {
+    Buffer b(*itr);
+    if (b.size() != 0u)
+      return b;
+  }
+  return Buffer();
+}
+
+inline std::uint32_t clamp_size(std::size_t size)
+{
+  return static_cast<std::uint32_t>((std::min)(size, static_cast<std::size_t>(UINT32_MAX)));
+}
+
+// libssh might have buffered data for us already, when another op on the same session processed packets,
+// so the read & write ops try once before waiting on the socket.
+template<typename Executor>
+struct async_channel_read_op
+{
+  basic_session<Executor> & sess;
+  ssh_channel channel;
+  traffic_stats & traffic;
+  net::mutable_buffer buffer;
+  bool is_stderr;
+  error_info * ei;
+  bool started = false;
+  op_instrument<op_kind::channel_read> instrument = {};
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    if (started)
+      return (*this)(std::move(self), error_code{});
+    started = true;
+    instrument.initiated(sess);
+    ssh_set_blocking(sess.native_handle(), 0);
+    net::post(std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    instrument.woken(sess);
+    if (ec || buffer.size() == 0u)
+      return instrument.complete(sess, self, ec, 0u);
+
+    int res = instrument.call(sess, [&]{
+      return ssh_channel_read_nonblocking(channel, buffer.data(), clamp_size(buffer.size()), is_stderr); });
+    if (res > 0)
+    {
+      traffic.received(static_cast<std::size_t>(res));
+      sess.traffic().received(static_cast<std::size_t>(res));
+      return instrument.complete(sess, self, ec, static_cast<std::size_t>(res));
+    }
+    else if (res == SSH_EOF || (res == 0 && ssh_channel_is_eof(channel)))
+    {
+      ASIOFY_ASSIGN_EC(ec, net::error::eof, net::error::get_misc_category());
+      return instrument.complete(sess, self, ec, 0u);
+    }
+    else if (res == 0 || res == SSH_AGAIN)
+    {
+      instrument.retried(sess);
+      instrument.waiting(sess, net::socket_base::wait_read);
+      return detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+    }
+
+    if (ei)
+      ei->set_message(ssh_get_error(sess.native_handle()));
+    ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+    instrument.complete(sess, self, ec, 0u);
+  }
+};
+
+// Like the read op, but it only takes a buffer from the pool once `ssh_channel_poll` reports data.
+template<typename Executor>
+struct async_channel_pooled_read_op
+{
+  basic_session<Executor> & sess;
+  ssh_channel channel;
+  traffic_stats & traffic;
+  buffer_pool & pool;
+  bool is_stderr;
+  bool started = false;
+  op_instrument<op_kind::channel_read> instrument = {};
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    if (started)
+      return (*this)(std::move(self), error_code{});
+    started = true;
+    instrument.initiated(sess);
+    ssh_set_blocking(sess.native_handle(), 0);
+    net::post(std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    instrument.woken(sess);
+    if (ec)
+      return instrument.complete(sess, self, ec, pooled_buffer{});
+
+    // the poll & the read are one libssh call as far as the stats & traces go, with the result of the read.
+    pooled_buffer buf;
+    int res = instrument.call(sess, [&]{
+      const int avail = ssh_channel_poll(channel, is_stderr);
+      if (avail <= 0)
+        return avail;
+      buf = pool.acquire();
+      return ssh_channel_read_nonblocking(channel, buf.data(), clamp_size(buf.size()), is_stderr);
+    });
+
+    if (res > 0)
+    {
+      buf.resize(static_cast<std::size_t>(res));
+      traffic.received(static_cast<std::size_t>(res));
+      sess.traffic().received(static_cast<std::size_t>(res));
+      return instrument.complete(sess, self, ec, std::move(buf));
+    }
+    else if (res == SSH_EOF || (res == 0 && ssh_channel_is_eof(channel)))
+    {
+      ASIOFY_ASSIGN_EC(ec, net::error::eof, net::error::get_misc_category());
+      return instrument.complete(sess, self, ec, pooled_buffer{});
+    }
+    else if (res == 0 || res == SSH_AGAIN)
+    {
+      // give the buffer back before waiting, in case the poll was too optimistic.
+      buf.reset();
+      instrument.retried(sess);
+      instrument.waiting(sess, net::socket_base::wait_read);
+      return detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+    }
+
+    ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+    instrument.complete(sess, self, ec, pooled_buffer{});
+  }
+};
+
+template<typename Executor>
+struct async_channel_write_op
+{
+  basic_session<Executor> & sess;
+  ssh_channel channel;
+  traffic_stats & traffic;
+  net::const_buffer buffer;
+  bool is_stderr;
+  error_info * ei;
+  bool started = false;
+  op_instrument<op_kind::channel_write> instrument = {};
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    if (started)
+      return (*this)(std::move(self), error_code{});
+    started = true;
+    instrument.initiated(sess);
+    ssh_set_blocking(sess.native_handle(), 0);
+    net::post(std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    instrument.woken(sess);
+    if (ec || buffer.size() == 0u)
+      return instrument.complete(sess, self, ec, 0u);
+
+    const auto s = sess.native_handle();
+    // libssh buffers everything in non-blocking mode, so we don't write more until the socket took it.
+    if ((ssh_get_status(s) & SSH_WRITE_PENDING) && ssh_blocking_flush(s, 0) == SSH_AGAIN)
+    {
+      instrument.retried(sess);
+      instrument.waiting(sess, net::socket_base::wait_write);
+      return detail::async_wait(sess, net::socket_base::wait_write, std::move(self));
+    }
+
+    int res = instrument.call(sess, [&]{
+      return is_stderr
+          ? ssh_channel_write_stderr(channel, buffer.data(), clamp_size(buffer.size()))
+          : ssh_channel_write       (channel, buffer.data(), clamp_size(buffer.size())); });
+
+    if (res > 0)
+    {
+      traffic.sent(static_cast<std::size_t>(res));
+      sess.traffic().sent(static_cast<std::size_t>(res));
+      return instrument.complete(sess, self, ec, static_cast<std::size_t>(res));
+    }
+    else if (res == 0 || res == SSH_AGAIN) // the window is exhausted, wait for the peer to adjust it.
+    {
+      traffic.stalled();
+      sess.traffic().stalled();
+      instrument.retried(sess);
+      instrument.waiting(sess, net::socket_base::wait_read);
+      return detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+    }
+
+    if (ei)
+      ei->set_message(ssh_get_error(s));
+    ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(s), ssh_category());
+    instrument.complete(sess, self, ec, 0u);
+  }
+};
+
+template<typename Executor>
+struct async_channel_exit_status_op
+{
+  basic_session<Executor> & sess;
+  ssh_channel channel;
+  error_info * ei;
+  bool started = false;
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    if (started)
+      return (*this)(std::move(self), error_code{});
+    started = true;
+    ssh_set_blocking(sess.native_handle(), 0);
+    net::post(std::move(self));
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    if (ec)
+      return self.complete(ec, -1);
+
+    const int res = ssh_channel_get_exit_status(channel);
+    if (res != -1)
+      return self.complete(ec, res);
+    else if (!ssh_is_connected(sess.native_handle()))
+    {
+      if (ei)
+        ei->set_message(ssh_get_error(sess.native_handle()));
+      ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+      return self.complete(ec, -1);
+    }
+    else if (ssh_channel_is_closed(channel))
+      return self.complete(ec, -1);
+
+    detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+  }
+};
+
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_session()
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_session(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_session(error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_session(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_open_session(RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::channel_open>(
+      *session_, id_,
+      [ch = handle_.get()](ssh_session) {return ssh_channel_open_session(ch);},
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_x11(const char * orig_addr, int orig_port)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_x11(handle_.get(), orig_addr, orig_port) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_x11(const char * orig_addr, int orig_port, error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_x11(handle_.get(), orig_addr, orig_port) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_open_x11(const char * orig_addr, int orig_port, RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::channel_open>(
+      *session_, id_,
+      [ch = handle_.get(), orig_addr, orig_port](ssh_session)
+      {
+        return ssh_channel_open_x11(ch, orig_addr, orig_port);
+      },
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_forward(const char * remote_host, int remote_port,
+                                           const char * source_host, int local_port)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_forward(handle_.get(), remote_host, remote_port, source_host, local_port) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_forward(const char * remote_host, int remote_port,
+                                           const char * source_host, int local_port,
+                                           error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_forward(handle_.get(), remote_host, remote_port, source_host, local_port) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_open_forward(const char * remote_host, int remote_port,
+                                            const char * source_host, int local_port,
+                                            RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::channel_open>(
+      *session_, id_,
+      [ch = handle_.get(), remote_host, remote_port, source_host, local_port](ssh_session)
+      {
+        return ssh_channel_open_forward(ch, remote_host, remote_port, source_host, local_port);
+      },
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_reverse_forward(const char * remote_host, int remote_port,
+                                                   const char * source_host, int local_port)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_reverse_forward(handle_.get(), remote_host, remote_port, source_host, local_port) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::open_reverse_forward(const char * remote_host, int remote_port,
+                                                   const char * source_host, int local_port,
+                                                   error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_open_reverse_forward(handle_.get(), remote_host, remote_port, source_host, local_port) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_open_reverse_forward(const char * remote_host, int remote_port,
+                                                    const char * source_host, int local_port,
+                                                    RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::channel_open>(
+      *session_, id_,
+      [ch = handle_.get(), remote_host, remote_port, source_host, local_port](ssh_session)
+      {
+        return ssh_channel_open_reverse_forward(ch, remote_host, remote_port, source_host, local_port);
+      },
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+template<typename MutableBufferSequence>
+std::size_t basic_channel<Executor>::read_some(const MutableBufferSequence & buffers, bool istderr)
+{
+  error_code ec;
+  auto n = read_some(buffers, istderr, ec);
+  if (ec)
+    throw_exception(system_error(ec, ssh_get_error(session_->native_handle())));
+  return n;
+}
+
+template<typename Executor>
+template<typename MutableBufferSequence>
+std::size_t basic_channel<Executor>::read_some(const MutableBufferSequence & buffers, bool istderr, error_code & ec)
+{
+  auto buf = detail::first_buffer<net::mutable_buffer>(buffers);
+  if (buf.size() == 0u)
+    return 0u;
+  ssh_set_blocking(session_->native_handle(), 1);
+  const int res = ssh_channel_read(handle_.get(), buf.data(), detail::clamp_size(buf.size()), istderr);
+  if (res > 0)
+  {
+    traffic_.received(static_cast<std::size_t>(res));
+    session_->traffic().received(static_cast<std::size_t>(res));
+    return static_cast<std::size_t>(res);
+  }
+  else if (res == 0 || res == SSH_EOF)
+    ASIOFY_ASSIGN_EC(ec, net::error::eof, net::error::get_misc_category())
+  else
+    ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(session_->native_handle()), ssh_category())
+  return 0u;
+}
+
+template<typename Executor>
+template<typename MutableBufferSequence,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) ReadToken>
+ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, std::size_t))
+basic_channel<Executor>::async_read_some(const MutableBufferSequence & buffers, bool istderr, ReadToken && token)
+{
+  return net::async_compose<ReadToken, void (error_code, std::size_t)>
+      (
+          detail::async_channel_read_op<Executor>{
+              *session_, handle_.get(), traffic_, detail::first_buffer<net::mutable_buffer>(buffers),
+              istderr, nullptr, false, id_},
+          token, *session_
+      );
+}
+
+template<typename Executor>
+pooled_buffer basic_channel<Executor>::read_some(buffer_pool & pool, bool istderr)
+{
+  error_code ec;
+  auto buf = read_some(pool, istderr, ec);
+  if (ec)
+    throw_exception(system_error(ec, ssh_get_error(session_->native_handle())));
+  return buf;
+}
+
+template<typename Executor>
+pooled_buffer basic_channel<Executor>::read_some(buffer_pool & pool, bool istderr, error_code & ec)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  int res = ssh_channel_poll_timeout(handle_.get(), -1, istderr);
+  pooled_buffer buf;
+  if (res > 0)
+  {
+    buf = pool.acquire();
+    // only ask for what's there, so the blocking read doesn't wait for a full buffer.
+    const auto n = (std::min)(static_cast<std::size_t>(res), buf.size());
+    res = ssh_channel_read(handle_.get(), buf.data(), detail::clamp_size(n), istderr);
+  }
+
+  if (res > 0)
+  {
+    buf.resize(static_cast<std::size_t>(res));
+    traffic_.received(static_cast<std::size_t>(res));
+    session_->traffic().received(static_cast<std::size_t>(res));
+    return buf;
+  }
+  else if (res == 0 || res == SSH_EOF)
+    ASIOFY_ASSIGN_EC(ec, net::error::eof, net::error::get_misc_category())
+  else
+    ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(session_->native_handle()), ssh_category())
+  return pooled_buffer{};
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, pooled_buffer)) ReadToken>
+ASIOFY_INITFN_RESULT_TYPE(ReadToken, void (error_code, pooled_buffer))
+basic_channel<Executor>::async_read_some(buffer_pool & pool, bool istderr, ReadToken && token)
+{
+  return net::async_compose<ReadToken, void (error_code, pooled_buffer)>
+      (
+          detail::async_channel_pooled_read_op<Executor>{
+              *session_, handle_.get(), traffic_, pool, istderr, false, id_},
+          token, *session_
+      );
+}
+
+template<typename Executor>
+template<typename ConstBufferSequence>
+std::size_t basic_channel<Executor>::write_some(const ConstBufferSequence & buffers, bool istderr)
+{
+  error_code ec;
+  auto n = write_some(buffers, istderr, ec);
+  if (ec)
+    throw_exception(system_error(ec, ssh_get_error(session_->native_handle())));
+  return n;
+}
+
+template<typename Executor>
+template<typename ConstBufferSequence>
+std::size_t basic_channel<Executor>::write_some(const ConstBufferSequence & buffers, bool istderr, error_code & ec)
+{
+  auto buf = detail::first_buffer<net::const_buffer>(buffers);
+  if (buf.size() == 0u)
+    return 0u;
+  ssh_set_blocking(session_->native_handle(), 1);
+  const int res = istderr
+      ? ssh_channel_write_stderr(handle_.get(), buf.data(), detail::clamp_size(buf.size()))
+      : ssh_channel_write       (handle_.get(), buf.data(), detail::clamp_size(buf.size()));
+  if (res > 0)
+  {
+    traffic_.sent(static_cast<std::size_t>(res));
+    session_->traffic().sent(static_cast<std::size_t>(res));
+  }
+  if (res >= 0)
+    return static_cast<std::size_t>(res);
+
+  ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(session_->native_handle()), ssh_category())
+  return 0u;
+}
+
+template<typename Executor>
+template<typename ConstBufferSequence,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, std::size_t)) WriteToken>
+ASIOFY_INITFN_RESULT_TYPE(WriteToken, void (error_code, std::size_t))
+basic_channel<Executor>::async_write_some(const ConstBufferSequence & buffers, bool istderr, WriteToken && token)
+{
+  return net::async_compose<WriteToken, void (error_code, std::size_t)>
+      (
+          detail::async_channel_write_op<Executor>{
+              *session_, handle_.get(), traffic_, detail::first_buffer<net::const_buffer>(buffers),
+              istderr, nullptr, false, id_},
+          token, *session_
+      );
+}
+
+template<typename Executor>
+void basic_channel<Executor>::request_exec(const char * cmd)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_request_exec(handle_.get(), cmd) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::request_exec(const char * cmd, error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_request_exec(handle_.get(), cmd) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_request_exec(const char * cmd, RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_read, net::socket_base::wait_write, op_kind::channel_request>(
+      *session_, id_,
+      [ch = handle_.get(), cmd](ssh_session) {return ssh_channel_request_exec(ch, cmd);},
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+void basic_channel<Executor>::send_eof()
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_send_eof(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::send_eof(error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_send_eof(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code))
+basic_channel<Executor>::async_send_eof(RequestToken && token)
+{
+  return detail::async_channel_op<net::socket_base::wait_write, net::socket_base::wait_write, op_kind::channel_request>(
+      *session_, id_,
+      [ch = handle_.get()](ssh_session) {return ssh_channel_send_eof(ch);},
+      nullptr, std::forward<RequestToken>(token));
+}
+
+template<typename Executor>
+int basic_channel<Executor>::exit_status()
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  return ssh_channel_get_exit_status(handle_.get());
+}
+
+template<typename Executor>
+int basic_channel<Executor>::exit_status(error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  const int res = ssh_channel_get_exit_status(handle_.get());
+  if (res == -1 && !ssh_is_connected(session_->native_handle()))
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+  return res;
+}
+
+template<typename Executor>
+template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, int)) RequestToken>
+ASIOFY_INITFN_RESULT_TYPE(RequestToken, void (error_code, int))
+basic_channel<Executor>::async_exit_status(RequestToken && token)
+{
+  return net::async_compose<RequestToken, void (error_code, int)>
+      (
+          detail::async_channel_exit_status_op<Executor>{*session_, handle_.get(), nullptr},
+          token, *session_
+      );
+}
+
+template<typename Executor>
+void basic_channel<Executor>::close()
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_close(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_THROW_ERROR(session_->native_handle())
+}
+
+template<typename Executor>
+void basic_channel<Executor>::close(error_code & ec, error_info & ei)
+{
+  ssh_set_blocking(session_->native_handle(), 1);
+  if (ssh_channel_close(handle_.get()) != SSH_OK)
+    ASIOFY_LIBSSH_ASSIGN_ERROR(ec, ei, session_->native_handle())
+}
+
+template<typename Executor>
+std::uint32_t basic_channel<Executor>::window_size()
+{
+  return ssh_channel_window_size(handle_.get());
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_IMPL_BASIC_CHANNEL_HPP
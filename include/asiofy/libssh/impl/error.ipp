@@ -10,7 +10,6 @@
 
 #include <libssh/libssh.h>
 #include <asiofy/libssh/error.hpp>
-#include <boost/core/detail/string_view.hpp>
 #include <algorithm>
 
 namespace asiofy
@@ -20,7 +19,9 @@ namespace libssh
 
 struct ssh_category_t final : error_category
 {
+#if !defined(ASIOFY_STANDALONE)
   ssh_category_t() : error_category(0x7d4c7b49e8a3edull) {}
+#endif
 
   std::string message( int ev ) const override
   {
@@ -35,18 +36,49 @@ struct ssh_category_t final : error_category
     }
   }
 
-  const char * name() const BOOST_NOEXCEPT override
+  const char * name() const noexcept override
   {
     return "libssh";
   }
 };
 
-error_category & ssh_category()
+ASIOFY_DECL error_category & ssh_category()
 {
   static ssh_category_t cat;
   return cat;
 }
 
+struct asiofy_category_t final : error_category
+{
+#if !defined(ASIOFY_STANDALONE)
+  asiofy_category_t() : error_category(0x7d4c7b49e8a3eeull) {}
+#endif
+
+  std::string message( int ev ) const override
+  {
+    switch (static_cast<errc>(ev))
+    {
+      case errc::auth_denied:      return "authentication denied";
+      case errc::auth_partial:     return "partial authentication, more methods required";
+      case errc::host_key_unknown: return "host key unknown";
+      case errc::host_key_changed: return "host key changed";
+      default:
+        return "unknown error";
+    }
+  }
+
+  const char * name() const noexcept override
+  {
+    return "asiofy.libssh";
+  }
+};
+
+ASIOFY_DECL error_category & asiofy_category()
+{
+  static asiofy_category_t cat;
+  return cat;
+}
+
 
 }
 }
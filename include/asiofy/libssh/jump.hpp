@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_JUMP_HPP
+#define ASIOFY_LIBSSH_JUMP_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/connect.hpp>
+#include <asiofy/libssh/transport.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/coroutine.hpp>
+#else
+#include <boost/asio/coroutine.hpp>
+#endif
+
+#include <memory>
+#include <string>
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+template<typename Executor, typename TargetExecutor>
+struct async_connect_jump_op : net::coroutine
+{
+  basic_session<Executor> & jump;
+  basic_session<TargetExecutor> & target;
+  std::string host;
+  unsigned short port;
+  std::string user;
+  error_info * ei;
+  // the direct-tcpip channel of the jump host, it lives until the transport is done.
+  std::shared_ptr<basic_channel<Executor>> channel;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      channel = std::make_shared<basic_channel<Executor>>(jump);
+      ASIOFY_CORO_YIELD channel->async_open_forward(host.c_str(), port, "127.0.0.1", 0, std::move(self));
+      if (ec)
+        return self.complete(ec);
+
+      {
+        auto c = channel;
+        async_run_transport(target, *c, [c](error_code) {});
+      }
+      // the transport couldn't give the target its end of the socketpair,
+      // so libssh would connect to the host directly.
+      if (!target.next_layer().is_open())
+      {
+        ASIOFY_ASSIGN_EC(ec, net::error::not_connected, net::error::get_system_category())
+        return self.complete(ec);
+      }
+
+      target.options_set(SSH_OPTIONS_HOST, host.c_str());
+      target.options_set(SSH_OPTIONS_PORT, static_cast<unsigned int>(port));
+      ASIOFY_CORO_YIELD net::async_compose<typename std::decay<Self>::type, void(error_code)>(
+            async_handshake_op<TargetExecutor>{{}, target, std::move(user), ei}, self, target);
+      self.complete(ec);
+    }
+  }
+};
+
+}
+
+/// Connect `target` to `host:port` through a direct-tcpip channel of the already authenticated `jump` session.
+/** This is the equivalent of `ssh -J`, without starting another process.
+ * Once connected, the host key gets verified against known_hosts and `target` gets authenticated as `user`
+ * with publickey auto, just like `async_connect`.
+ *
+ * The channel gets pumped into the target with `async_run_transport` and stays open until the target disconnects.
+ * `jump` must outlive `target` and both need to use executors that run on the same thread.
+ */
+template<typename Executor, typename TargetExecutor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(TargetExecutor)>
+ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+async_connect_jump(basic_session<Executor> & jump, basic_session<TargetExecutor> & target,
+                   std::string host, unsigned short port, std::string user,
+                   ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(TargetExecutor))
+{
+  return net::async_compose<ConnectToken, void (error_code)>
+      (
+          detail::async_connect_jump_op<Executor, TargetExecutor>{
+              {}, jump, target, std::move(host), port, std::move(user), nullptr, nullptr},
+          token, target, jump
+      );
+}
+
+template<typename Executor, typename TargetExecutor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ConnectToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(TargetExecutor)>
+ASIOFY_INITFN_RESULT_TYPE(ConnectToken, void (error_code))
+async_connect_jump(basic_session<Executor> & jump, basic_session<TargetExecutor> & target,
+                   std::string host, unsigned short port, std::string user,
+                   error_info & ei,
+                   ConnectToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(TargetExecutor))
+{
+  return net::async_compose<ConnectToken, void (error_code)>
+      (
+          detail::async_connect_jump_op<Executor, TargetExecutor>{
+              {}, jump, target, std::move(host), port, std::move(user), &ei, nullptr},
+          token, target, jump
+      );
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_JUMP_HPP
@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_LOG_HPP
+#define ASIOFY_LIBSSH_LOG_HPP
+
+#include <libssh/libssh.h>
+#include <libssh/callbacks.h>
+#include <asiofy/libssh/detail/config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// A message libssh logged, truncated to fit.
+struct log_record
+{
+  std::chrono::system_clock::time_point time;
+  /// The libssh log level, e.g. SSH_LOG_PROTOCOL.
+  int priority;
+  char function[64];
+  char message[512];
+};
+
+/// Takes the log of libssh off the I/O threads.
+/** Once installed, libssh passes its log to the sink, which only copies it into a lock-free ring buffer.
+ * A background thread takes the records out & hands them to the writer, and sleeps while there are none.
+ * If the buffer is full, records get dropped & counted, the I/O thread never waits for the writer.
+ * It only takes a lock to wake the background thread, if that is asleep.
+ *
+ * libssh keeps the log callback per thread, so `install` needs to be called on every thread running sessions.
+ * Uninstall it on all of them before the sink is destroyed.
+ */
+class async_log_sink
+{
+ public:
+  using writer_type = std::function<void(const log_record &)>;
+
+  /// @param capacity The number of records buffered, rounded up to a power of two.
+  explicit async_log_sink(std::size_t capacity = 4096u, writer_type writer = &write_to_stderr)
+      : mask_(round_up(capacity) - 1u), slots_(new slot[mask_ + 1u]), writer_(std::move(writer))
+  {
+    for (std::size_t i = 0u; i <= mask_; i++)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    thread_ = std::thread([this]{ run(); });
+  }
+
+  async_log_sink(const async_log_sink &) = delete;
+  async_log_sink& operator=(const async_log_sink &) = delete;
+
+  /// Writes what's left in the buffer & stops the background thread.
+  ~async_log_sink()
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      running_.store(false, std::memory_order_release);
+    }
+    wakeup_.notify_one();
+    thread_.join();
+  }
+
+  /// Make libssh log to this sink on the calling thread.
+  void install()
+  {
+    ssh_set_log_userdata(this);
+    ssh_set_log_callback(&async_log_sink::callback);
+  }
+
+  /// Make libssh log to stderr again on the calling thread.
+  static void uninstall()
+  {
+    // libssh rejects a null callback & would keep calling ours, so replace it with one like its default.
+    ssh_set_log_callback(&async_log_sink::stderr_callback);
+    ssh_set_log_userdata(nullptr);
+  }
+
+  /// Queue a record, returns false if it was dropped. Can be called from any thread.
+  bool push(int priority, const char * function, const char * message)
+  {
+    auto pos = enqueue_.load(std::memory_order_relaxed);
+    slot * s;
+    for (;;)
+    {
+      s = &slots_[pos & mask_];
+      const auto seq = s->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (enqueue_.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        dropped_.fetch_add(1u, std::memory_order_relaxed);
+        return false;
+      }
+      else
+        pos = enqueue_.load(std::memory_order_relaxed);
+    }
+
+    s->record.time = std::chrono::system_clock::now();
+    s->record.priority = priority;
+    copy(s->record.function, function);
+    copy(s->record.message, message);
+    s->sequence.store(pos + 1u, std::memory_order_release);
+
+    // pairs with the fence in `run`, so either this sees the thread asleep or the thread sees the record.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed))
+    {
+      { std::lock_guard<std::mutex> lock{mutex_}; }
+      wakeup_.notify_one();
+    }
+    return true;
+  }
+
+  /// The number of records dropped, because the buffer was full.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// The number of records passed to the writer.
+  std::uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+  /// The default writer, which prints the record like libssh would.
+  static void write_to_stderr(const log_record & rec)
+  {
+    const auto t = std::chrono::duration_cast<std::chrono::microseconds>(rec.time.time_since_epoch()).count();
+    std::fprintf(stderr, "[%lld.%06lld, %d] %s: %s\n",
+                 static_cast<long long>(t / 1000000), static_cast<long long>(t % 1000000),
+                 rec.priority, rec.function, rec.message);
+  }
+
+ private:
+  struct slot
+  {
+    std::atomic<std::size_t> sequence;
+    log_record record;
+  };
+
+  static std::size_t round_up(std::size_t n)
+  {
+    std::size_t res = 2u;
+    while (res < n)
+      res <<= 1u;
+    return res;
+  }
+
+  template<std::size_t Size>
+  static void copy(char (&target)[Size], const char * source)
+  {
+    const auto len = source ? (std::min)(std::strlen(source), Size - 1u) : 0u;
+    if (len > 0u)
+      std::memcpy(target, source, len);
+    target[len] = '\0';
+  }
+
+  static void callback(int priority, const char * function, const char * buffer, void * userdata)
+  {
+    if (userdata != nullptr)
+      static_cast<async_log_sink*>(userdata)->push(priority, function, buffer);
+  }
+
+  static void stderr_callback(int priority, const char * function, const char * buffer, void *)
+  {
+    std::fprintf(stderr, "[%d] %s: %s\n", priority, function != nullptr ? function : "", buffer);
+  }
+
+  bool ready() const
+  {
+    return slots_[dequeue_ & mask_].sequence.load(std::memory_order_acquire) == dequeue_ + 1u;
+  }
+
+  bool pop()
+  {
+    if (!ready())
+      return false;
+    slot & s = slots_[dequeue_ & mask_];
+    writer_(s.record);
+    written_.fetch_add(1u, std::memory_order_relaxed);
+    s.sequence.store(dequeue_ + mask_ + 1u, std::memory_order_release);
+    dequeue_++;
+    return true;
+  }
+
+  void run()
+  {
+    while (running_.load(std::memory_order_acquire))
+    {
+      if (pop())
+        continue;
+
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        wakeup_.wait(lock, [this]{ return ready() || !running_.load(std::memory_order_acquire); });
+      }
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+    while (pop());
+  }
+
+  const std::size_t mask_;
+  std::unique_ptr<slot[]> slots_;
+  writer_type writer_;
+  std::atomic<std::size_t> enqueue_{0u};
+  std::size_t dequeue_ = 0u; // only used by the background thread
+  std::atomic<std::uint64_t> dropped_{0u}, written_{0u};
+  std::atomic<bool> running_{true};
+  std::atomic<bool> sleeping_{false};
+  // only guards the sleep of the background thread, the records don't need it.
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::thread thread_;
+};
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_LOG_HPP
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_MESSAGE_HPP
+#define ASIOFY_LIBSSH_MESSAGE_HPP
+
+#include <libssh/server.h>
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/handles.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/error.hpp>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// An owning handle of a message received by a server session.
+using message_handle = detail::unique_handle<ssh_message, ssh_message_free>;
+
+namespace detail
+{
+
+template<typename Executor>
+struct async_get_message_op
+{
+  basic_session<Executor> & sess;
+  error_info * ei;
+
+  template<typename Self>
+  void operator()(Self && self)
+  {
+    ssh_set_blocking(sess.native_handle(), 0);
+    (*this)(std::move(self), error_code{});
+  }
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec)
+  {
+    if (ec)
+      return self.complete(ec, message_handle{});
+
+    message_handle msg{ssh_message_get(sess.native_handle())};
+    if (msg)
+      return self.complete(ec, std::move(msg));
+
+    // the error code is sticky, a non-fatal one like SSH_REQUEST_DENIED is left over from an earlier request.
+    if (ssh_get_error_code(sess.native_handle()) == SSH_FATAL
+        || (ssh_get_status(sess.native_handle()) & SSH_CLOSED_ERROR) != 0)
+    {
+      ASIOFY_ASSIGN_EC(ec, ssh_get_error_code(sess.native_handle()), ssh_category());
+      if (ei)
+        ei->set_message(ssh_get_error(sess.native_handle()));
+      return self.complete(ec, message_handle{});
+    }
+    if (!sess.is_connected())
+    {
+      ASIOFY_ASSIGN_EC(ec, net::error::eof, net::error::get_misc_category());
+      return self.complete(ec, message_handle{});
+    }
+    detail::async_wait(sess, net::socket_base::wait_read, std::move(self));
+  }
+};
+
+}
+
+/// Wait for the next message on a server session.
+/** The message must be replied to, e.g. with `ssh_message_reply_default`. Completes with `net::error::eof`
+ * when the client disconnected. */
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, message_handle)) MessageToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(MessageToken, void (error_code, message_handle))
+async_get_message(basic_session<Executor> & sess,
+                  MessageToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<MessageToken, void (error_code, message_handle)>(
+      detail::async_get_message_op<Executor>{sess, nullptr}, token, sess.next_layer());
+}
+
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, message_handle)) MessageToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(MessageToken, void (error_code, message_handle))
+async_get_message(basic_session<Executor> & sess, error_info & ei,
+                  MessageToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_compose<MessageToken, void (error_code, message_handle)>(
+      detail::async_get_message_op<Executor>{sess, &ei}, token, sess.next_layer());
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_MESSAGE_HPP
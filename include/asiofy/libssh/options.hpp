@@ -8,4 +8,274 @@
 #ifndef ASIOFY_OPTIONS_HPP
 #define ASIOFY_OPTIONS_HPP
 
+#include <libssh/libssh.h>
+#include <libssh/server.h>
+#include <asiofy/libssh/detail/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+// True if every value of the integer type From fits into To.
+template<typename To, typename From>
+struct is_widening_integer : std::integral_constant<bool,
+       std::is_integral<To>::value && !std::is_same<To, bool>::value
+    && std::is_integral<From>::value && !std::is_same<From, bool>::value
+    && (std::is_signed<To>::value == std::is_signed<From>::value ? sizeof(From) <= sizeof(To)
+                                                                 : std::is_signed<To>::value && sizeof(From) < sizeof(To))>
+{
+};
+
+// A value can be used for an option of type T if it's the same type, a string for a string
+// or an integer that fits into it. Anything else, e.g. a bool or a double for an int,
+// or an int for an unsigned, gets rejected.
+template<typename T, typename U, typename Value = typename std::decay<U>::type>
+struct is_option_value : std::integral_constant<bool,
+       std::is_same<T, Value>::value
+    || is_widening_integer<T, Value>::value
+    || (std::is_same<T, const char *>::value && std::is_convertible<U, const char *>::value &&
+        !std::is_same<Value, std::nullptr_t>::value)>
+{
+};
+
+template<typename T>
+constexpr bool option_value_valid(const T &) { return true; }
+constexpr bool option_value_valid(const char * value) { return value != nullptr; }
+constexpr bool option_value_valid(ssh_key value) { return value != nullptr; }
+
+// libssh takes strings & keys themselves, everything else through a pointer.
+template<typename T>
+const void * option_pointer(const T & value) { return &value; }
+inline const void * option_pointer(const char * value) { return value; }
+inline const void * option_pointer(ssh_key value) { return value; }
+
+template<typename Enum, Enum Option, typename T>
+struct basic_option
+{
+  constexpr static Enum option = Option;
+  using value_type = T;
+  value_type value = {};
+
+  constexpr basic_option() = default;
+  template<typename U>
+  constexpr explicit basic_option(U && v) : value(static_cast<value_type>(v))
+  {
+    static_assert(is_option_value<value_type, U>::value, "the value has the wrong type for this option");
+  }
+
+  /// Strings & keys must not be null.
+  constexpr bool valid() const { return option_value_valid(value); }
+};
+
+template<typename Enum, Enum Option, typename T>
+constexpr Enum basic_option<Enum, Option, T>::option;
+
+inline ssh_session option_target(ssh_session session) { return session; }
+inline ssh_bind    option_target(ssh_bind bind)       { return bind; }
+
+template<typename Struct, typename Deleter>
+Struct * option_target(const std::unique_ptr<Struct, Deleter> & handle) { return handle.get(); }
+
+template<typename Object>
+auto option_target(Object & object) -> decltype(object.native_handle()) { return object.native_handle(); }
+
+template<typename Handle>
+struct handle_of
+{
+  using handle_type = Handle;
+};
+
+template<typename ... Ts>
+struct same_handle : std::true_type {};
+
+template<typename T, typename U, typename ... Ts>
+struct same_handle<T, U, Ts...>
+    : std::integral_constant<bool, std::is_same<typename T::handle_type, typename U::handle_type>::value &&
+                                   same_handle<U, Ts...>::value>
+{
+};
+
+// the last value is a sentinel, so this works for empty sets too.
+template<std::size_t Size>
+constexpr bool options_unique(const int (&options)[Size], const bool (&repeatable)[Size])
+{
+  for (std::size_t i = 0u; i < Size - 1u; i++)
+    for (std::size_t j = i + 1u; j < Size - 1u; j++)
+      if (options[i] == options[j] && !repeatable[i])
+        return false;
+  return true;
+}
+
+}
+
+/// A type-safe option of a session, see `ssh_options_set`.
+template<ssh_options_e Option, typename T>
+struct session_option : detail::basic_option<ssh_options_e, Option, T>
+{
+  using handle_type = ssh_session;
+  using detail::basic_option<ssh_options_e, Option, T>::basic_option;
+
+  /// Every identity set gets added to the list, so these can be given more than once.
+  constexpr static bool repeatable = Option == SSH_OPTIONS_IDENTITY || Option == SSH_OPTIONS_ADD_IDENTITY;
+
+  bool apply(ssh_session session) const
+  {
+    return ssh_options_set(session, Option, detail::option_pointer(this->value)) == SSH_OK;
+  }
+};
+
+template<ssh_options_e Option, typename T>
+constexpr bool session_option<Option, T>::repeatable;
+
+namespace options
+{
+
+using host                     = session_option<SSH_OPTIONS_HOST,                     const char *>;
+using port                     = session_option<SSH_OPTIONS_PORT,                     unsigned>;
+using port_str                 = session_option<SSH_OPTIONS_PORT_STR,                 const char *>;
+using user                     = session_option<SSH_OPTIONS_USER,                     const char *>;
+using ssh_dir                  = session_option<SSH_OPTIONS_SSH_DIR,                  const char *>;
+using identity                 = session_option<SSH_OPTIONS_IDENTITY,                 const char *>;
+using add_identity             = session_option<SSH_OPTIONS_ADD_IDENTITY,             const char *>;
+using knownhosts               = session_option<SSH_OPTIONS_KNOWNHOSTS,               const char *>;
+using global_knownhosts        = session_option<SSH_OPTIONS_GLOBAL_KNOWNHOSTS,        const char *>;
+using timeout                  = session_option<SSH_OPTIONS_TIMEOUT,                  long>;
+using timeout_usec             = session_option<SSH_OPTIONS_TIMEOUT_USEC,             long>;
+using log_verbosity            = session_option<SSH_OPTIONS_LOG_VERBOSITY,            int>;
+using log_verbosity_str        = session_option<SSH_OPTIONS_LOG_VERBOSITY_STR,        const char *>;
+using ciphers_c_s              = session_option<SSH_OPTIONS_CIPHERS_C_S,              const char *>;
+using ciphers_s_c              = session_option<SSH_OPTIONS_CIPHERS_S_C,              const char *>;
+using compression              = session_option<SSH_OPTIONS_COMPRESSION,              const char *>;
+using compression_c_s          = session_option<SSH_OPTIONS_COMPRESSION_C_S,          const char *>;
+using compression_s_c          = session_option<SSH_OPTIONS_COMPRESSION_S_C,          const char *>;
+using compression_level        = session_option<SSH_OPTIONS_COMPRESSION_LEVEL,        int>;
+using proxycommand             = session_option<SSH_OPTIONS_PROXYCOMMAND,             const char *>;
+using bindaddr                 = session_option<SSH_OPTIONS_BINDADDR,                 const char *>;
+using stricthostkeycheck       = session_option<SSH_OPTIONS_STRICTHOSTKEYCHECK,       int>;
+using key_exchange             = session_option<SSH_OPTIONS_KEY_EXCHANGE,             const char *>;
+using hostkeys                 = session_option<SSH_OPTIONS_HOSTKEYS,                 const char *>;
+using hmac_c_s                 = session_option<SSH_OPTIONS_HMAC_C_S,                 const char *>;
+using hmac_s_c                 = session_option<SSH_OPTIONS_HMAC_S_C,                 const char *>;
+using password_auth            = session_option<SSH_OPTIONS_PASSWORD_AUTH,            int>;
+using pubkey_auth              = session_option<SSH_OPTIONS_PUBKEY_AUTH,              int>;
+using kbdint_auth              = session_option<SSH_OPTIONS_KBDINT_AUTH,              int>;
+using gssapi_auth              = session_option<SSH_OPTIONS_GSSAPI_AUTH,              int>;
+using nodelay                  = session_option<SSH_OPTIONS_NODELAY,                  int>;
+using publickey_accepted_types = session_option<SSH_OPTIONS_PUBLICKEY_ACCEPTED_TYPES, const char *>;
+using process_config           = session_option<SSH_OPTIONS_PROCESS_CONFIG,           bool>;
+using rekey_data               = session_option<SSH_OPTIONS_REKEY_DATA,               std::uint64_t>;
+using rekey_time               = session_option<SSH_OPTIONS_REKEY_TIME,               std::uint32_t>;
+using rsa_min_size             = session_option<SSH_OPTIONS_RSA_MIN_SIZE,             int>;
+
+}
+
+template<ssh_options_e Option, typename T>
+bool apply_config(ssh_session session, const session_option<Option, T> & so)
+{
+  return so.apply(session);
+}
+
+/// A set of options, that can be built once & applied to any number of sessions or binds.
+/** The options are checked when the set is built: all of them need to be for the same kind of handle
+ * and only the ones that add to a list may be given twice. If the set is `constexpr`, `valid()`
+ * can be checked with a `static_assert`, so a missing string shows up at compile time, not on every new session.
+ *
+ * libssh copies strings when they're set, so they only need to outlive the set.
+ *
+ * @code
+ * constexpr auto client_options = make_options(options::user{"deploy"}, options::port{22u}, options::nodelay{1});
+ * static_assert(client_options.valid(), "invalid client options");
+ * @endcode
+ */
+template<typename ... Options>
+struct option_set
+{
+  static_assert(detail::same_handle<Options...>::value, "all options in a set need to be for the same handle type");
+  static_assert(detail::options_unique<sizeof...(Options) + 1u>({static_cast<int>(Options::option)..., -1},
+                                                               {Options::repeatable..., true}),
+                "an option is set more than once");
+
+  std::tuple<Options...> options;
+
+  constexpr explicit option_set(const Options & ... opts) : options(opts...) {}
+
+  /// The number of options.
+  constexpr static std::size_t size() { return sizeof...(Options); }
+
+  /// True if every value is valid, i.e. no string or key is null.
+  constexpr bool valid() const
+  {
+    return valid_impl(std::make_index_sequence<sizeof...(Options)>{});
+  }
+
+  /// Apply the options in order, stopping at the first one libssh rejects.
+  template<typename Handle>
+  bool apply(Handle handle) const
+  {
+    static_assert(detail::same_handle<detail::handle_of<Handle>, Options...>::value,
+                  "the options are for a different handle type");
+    return apply_impl(handle, std::make_index_sequence<sizeof...(Options)>{});
+  }
+
+ private:
+  template<std::size_t ... Idx>
+  constexpr bool valid_impl(std::index_sequence<Idx...>) const
+  {
+    const bool valid[] = {true, std::get<Idx>(options).valid()...};
+    for (bool v : valid)
+      if (!v)
+        return false;
+    return true;
+  }
+
+  template<typename Handle, std::size_t ... Idx>
+  bool apply_impl(Handle handle, std::index_sequence<Idx...>) const
+  {
+    bool ok = true;
+    // a braced list is evaluated left to right.
+    const bool applied[] = {true, (ok = ok && std::get<Idx>(options).apply(handle))...};
+    static_cast<void>(applied);
+    static_cast<void>(handle); // unused by an empty set
+    return ok;
+  }
+};
+
+/// Build an `option_set`.
+template<typename ... Options>
+constexpr option_set<Options...> make_options(const Options & ... options)
+{
+  return option_set<Options...>(options...);
+}
+
+/// Apply an option set to a session or bind, given as raw handle, owning handle or object with a `native_handle()`.
+template<typename Target, typename ... Options>
+bool apply_config(Target && target, const option_set<Options...> & os)
+{
+  return os.apply(detail::option_target(target));
+}
+
+/// Apply an option set to every session or bind in a range, returns the number it was fully applied to.
+template<typename Range, typename ... Options>
+std::size_t apply_config_all(Range && targets, const option_set<Options...> & os)
+{
+  std::size_t n = 0u;
+  for (auto && target : targets)
+    if (os.apply(detail::option_target(target)))
+      n++;
+  return n;
+}
+
+}
+}
+
 #endif //ASIOFY_OPTIONS_HPP
@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_REVERSE_FORWARD_HPP
+#define ASIOFY_LIBSSH_REVERSE_FORWARD_HPP
+
+#include <libssh/server.h>
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/forward.hpp>
+#include <asiofy/libssh/message.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/basic_socket_acceptor.hpp>
+#include <asio/coroutine.hpp>
+#include <asio/ip/tcp.hpp>
+#else
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#endif
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+template<typename Executor>
+struct basic_reverse_forwarder;
+
+namespace detail
+{
+
+template<typename Executor>
+struct reverse_forward_run_op : net::coroutine
+{
+  basic_reverse_forwarder<Executor> & fwd;
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {}, message_handle msg = {})
+  {
+    ASIOFY_CORO_REENTER(*this)
+    {
+      for (;;)
+      {
+        ASIOFY_CORO_YIELD async_get_message(fwd.session(), std::move(self));
+        if (ec)
+          return self.complete(ec);
+        if (!fwd.handle_message(msg.get()))
+          ssh_message_reply_default(msg.get());
+      }
+    }
+  }
+};
+
+}
+
+/// The server side of `ssh -R`: listens on the ports a client requests and forwards connections back to it.
+/** Every listener runs on the executor of the session and opens a forwarded-tcpip channel per connection,
+ * which gets pumped with `async_bridge`. The session must outlive the forwarder.
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_reverse_forwarder
+{
+  /// The type of the executor associated with the object.
+  typedef Executor executor_type;
+
+  /// Rebinds the forwarder type to another executor.
+  template <typename Executor1>
+  struct rebind_executor
+  {
+    /// The forwarder type when rebound to the specified executor.
+    typedef basic_reverse_forwarder<Executor1> other;
+  };
+
+  typedef basic_session<executor_type> session_type;
+  typedef net::basic_socket_acceptor<net::ip::tcp, executor_type> acceptor_type;
+
+  explicit basic_reverse_forwarder(session_type & sess, const forward_options & options = {})
+      : sess_(sess), options_(options)
+  {
+  }
+
+  basic_reverse_forwarder(const basic_reverse_forwarder &) = delete;
+  basic_reverse_forwarder & operator=(const basic_reverse_forwarder &) = delete;
+
+  executor_type get_executor() noexcept { return sess_.get_executor(); }
+  session_type & session() { return sess_; }
+
+  /// The number of open listeners.
+  std::size_t size() const { return listeners_.size(); }
+
+  /// Handle & reply to a tcpip-forward or cancel-tcpip-forward request.
+  /** Returns false if `msg` is any other message, in which case it hasn't been replied to. */
+  bool handle_message(ssh_message msg)
+  {
+    if (ssh_message_type(msg) != SSH_REQUEST_GLOBAL)
+      return false;
+
+    switch (ssh_message_subtype(msg))
+    {
+      case SSH_GLOBAL_REQUEST_TCPIP_FORWARD:
+      {
+        error_code ec;
+        const auto port = listen(ssh_message_global_request_address(msg),
+                                 ssh_message_global_request_port(msg), ec);
+        if (ec)
+          ssh_message_reply_default(msg);
+        else
+          ssh_message_global_request_reply_success(msg, port);
+        return true;
+      }
+      case SSH_GLOBAL_REQUEST_CANCEL_TCPIP_FORWARD:
+      {
+        if (cancel(ssh_message_global_request_address(msg), ssh_message_global_request_port(msg)))
+          ssh_message_global_request_reply_success(msg, 0u);
+        else
+          ssh_message_reply_default(msg);
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  /// Handle messages until the session closes.
+  /** Forwarding requests get handled, every other message gets the default reply, i.e. gets denied.
+   * Use `async_get_message` & `handle_message` directly if the session serves other requests, too. */
+  template<ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RunToken
+             ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(RunToken, void (error_code))
+  async_run(RunToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return net::async_compose<RunToken, void (error_code)>(
+        detail::reverse_forward_run_op<executor_type>{{}, *this}, token, sess_.next_layer());
+  }
+
+  /// Close all listeners. Connections that are already forwarded stay open.
+  void close()
+  {
+    for (auto & l : listeners_)
+    {
+      error_code ig;
+      l.second->close(ig);
+    }
+    listeners_.clear();
+  }
+
+  ~basic_reverse_forwarder()
+  {
+    close();
+  }
+
+ private:
+
+  // returns the bound port.
+  std::uint16_t listen(const char * address, int port, error_code & ec)
+  {
+    const std::string addr = address != nullptr ? address : "";
+    net::ip::address ip;
+    if (addr.empty() || addr == "*" || addr == "0.0.0.0")
+      ip = net::ip::address_v4::any();
+    else if (addr == "localhost")
+      ip = net::ip::address_v4::loopback();
+    else
+      ip = net::ip::make_address(addr, ec);
+
+    if (ec)
+      return 0u;
+
+    auto acceptor = std::allocate_shared<acceptor_type>(sess_.get_allocator(), sess_.get_executor());
+    const net::ip::tcp::endpoint ep{ip, static_cast<std::uint16_t>(port)};
+    acceptor->open(ep.protocol(), ec);
+    if (!ec)
+      acceptor->set_option(net::socket_base::reuse_address(true), ec);
+    if (!ec)
+      acceptor->bind(ep, ec);
+    if (!ec)
+      acceptor->listen(net::socket_base::max_listen_connections, ec);
+    if (ec)
+      return 0u;
+
+    const auto bound = acceptor->local_endpoint(ec).port();
+    if (ec)
+      return 0u;
+
+    // the client refers to the listener by the port that got bound.
+    listeners_[std::make_pair(addr, static_cast<int>(bound))] = acceptor;
+
+    auto state = std::allocate_shared<detail::forward_state<executor_type>>(
+        sess_.get_allocator(), detail::forward_state<executor_type>{sess_, addr, bound, options_, true});
+    // keeps the acceptor alive after cancel until the accept op completed.
+    auto on_done = [acceptor](error_code) {};
+    net::async_compose<decltype(on_done), void(error_code)>(
+        detail::forward_accept_op<executor_type>{{}, *acceptor, std::move(state), nullptr}, on_done, *acceptor);
+    return bound;
+  }
+
+  bool cancel(const char * address, int port)
+  {
+    auto itr = listeners_.find(std::make_pair(std::string(address != nullptr ? address : ""), port));
+    if (itr == listeners_.end())
+      return false;
+    error_code ig;
+    itr->second->close(ig);
+    listeners_.erase(itr);
+    return true;
+  }
+
+  session_type & sess_;
+  forward_options options_;
+  std::map<std::pair<std::string, int>, std::shared_ptr<acceptor_type>> listeners_;
+};
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_REVERSE_FORWARD_HPP
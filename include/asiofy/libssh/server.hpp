@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_SERVER_HPP
+#define ASIOFY_LIBSSH_SERVER_HPP
+
+#include <libssh/server.h>
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/macros.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/bind.hpp>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// Perform the key exchange of a session accepted by a `basic_bind`.
+/** Provides `handle_key_exchange` and `async_handle_key_exchange`. */
+ASIOFY_LIBSSH_WRAP_FREE_SESSION_ASYNC_CALL_0(wait_read, key_exchange, handle_key_exchange)
+
+#define ASIOFY_LIBSSH_INSTANTIATE_SERVER(Extern, Executor)                                                           \
+  Extern template void handle_key_exchange(basic_session<Executor> &);                                               \
+  Extern template void handle_key_exchange(basic_session<Executor> &, error_code &, error_info &);
+
+#if defined(ASIOFY_SEPARATE_COMPILATION)
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_SERVER, extern)
+#endif
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_SERVER_HPP
@@ -0,0 +1,451 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_SESSION_POOL_HPP
+#define ASIOFY_LIBSSH_SESSION_POOL_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/connect.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/coroutine.hpp>
+#include <asio/steady_timer.hpp>
+#else
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/steady_timer.hpp>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// The key of a pooled session.
+struct session_key
+{
+  std::string host;
+  unsigned short port = 22u;
+  std::string user;
+
+  friend bool operator<(const session_key & lhs, const session_key & rhs)
+  {
+    return std::tie(lhs.host, lhs.port, lhs.user) < std::tie(rhs.host, rhs.port, rhs.user);
+  }
+  friend bool operator==(const session_key & lhs, const session_key & rhs)
+  {
+    return std::tie(lhs.host, lhs.port, lhs.user) == std::tie(rhs.host, rhs.port, rhs.user);
+  }
+};
+
+struct session_pool_options
+{
+  /// The maximum of channels open on one session. 10 is the MaxSessions default of OpenSSH.
+  std::size_t max_channels_per_session = 10u;
+  /// The maximum number of sessions per key.
+  std::size_t max_sessions_per_key = 4u;
+  /// Sessions without channels get closed after this.
+  std::chrono::steady_clock::duration idle_timeout = std::chrono::minutes(5);
+  /// Interval of the health check, that sends keep-alives, processes pending packets & evicts idle sessions.
+  std::chrono::steady_clock::duration health_check_interval = std::chrono::seconds(30);
+  /// Gets applied to every session before it connects, e.g. to set SSH_OPTIONS_KNOWNHOSTS or add an identity.
+  std::function<void(ssh_session)> configure;
+};
+
+template<typename Executor>
+struct basic_session_pool;
+
+namespace detail
+{
+
+template<typename Executor>
+using pool_timer = net::basic_waitable_timer<std::chrono::steady_clock,
+                                             net::wait_traits<std::chrono::steady_clock>,
+                                             Executor>;
+
+template<typename Executor>
+struct session_pool_state;
+
+template<typename Executor>
+struct session_pool_entry
+{
+  session_pool_entry(const Executor & executor, session_key key, std::weak_ptr<session_pool_state<Executor>> pool)
+      : key(std::move(key)), session(executor), ready_signal(executor), pool(std::move(pool))
+  {
+    ready_signal.expires_at(std::chrono::steady_clock::time_point::max());
+  }
+
+  ~session_pool_entry()
+  {
+    session.disconnect();
+  }
+
+  session_key key;
+  basic_session<Executor> session;
+  // cancelled once the session is authenticated or failed.
+  pool_timer<Executor> ready_signal;
+  std::weak_ptr<session_pool_state<Executor>> pool;
+
+  std::size_t channels = 0u;
+  std::chrono::steady_clock::time_point last_used = std::chrono::steady_clock::now();
+  bool connecting = false;
+  bool ready  = false;
+  bool broken = false;
+  error_code error;
+
+  void release_channel();
+};
+
+template<typename Executor>
+struct session_pool_state : std::enable_shared_from_this<session_pool_state<Executor>>
+{
+  using entry_type = session_pool_entry<Executor>;
+
+  session_pool_state(const Executor & executor, const session_pool_options & options)
+      : executor(executor), options(options), slot_signal(executor), health_timer(executor)
+  {
+    slot_signal.expires_at(std::chrono::steady_clock::time_point::max());
+  }
+
+  Executor executor;
+  session_pool_options options;
+  std::map<session_key, std::vector<std::shared_ptr<entry_type>>> sessions;
+  // cancelled whenever a channel slot gets freed.
+  pool_timer<Executor> slot_signal;
+  pool_timer<Executor> health_timer;
+  bool health_check_running = false;
+  // set by close, pending & later acquires fail with operation_aborted.
+  bool closed = false;
+
+  // reserves a channel slot or returns nullptr if the caller needs to wait.
+  std::shared_ptr<entry_type> reserve(const session_key & key)
+  {
+    auto & entries = sessions[key];
+    auto itr = std::find_if(entries.begin(), entries.end(),
+                            [&](const std::shared_ptr<entry_type> & e)
+                            {
+                              return !e->broken && e->channels < options.max_channels_per_session;
+                            });
+    if (itr == entries.end())
+    {
+      if (entries.size() >= options.max_sessions_per_key)
+        return nullptr;
+      entries.push_back(std::make_shared<entry_type>(executor, key, this->shared_from_this()));
+      itr = std::prev(entries.end());
+    }
+    (*itr)->channels++;
+    return *itr;
+  }
+
+  void evict(const entry_type * e)
+  {
+    auto itr = sessions.find(e->key);
+    if (itr == sessions.end())
+      return;
+    auto & entries = itr->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [e](const std::shared_ptr<entry_type> & ptr) {return ptr.get() == e;}),
+                  entries.end());
+    if (entries.empty())
+      sessions.erase(itr);
+    slot_signal.cancel();
+  }
+
+  void start_health_check()
+  {
+    if (health_check_running)
+      return;
+    health_check_running = true;
+    health_timer.expires_after(options.health_check_interval);
+    health_timer.async_wait(
+        [wp = std::weak_ptr<session_pool_state>(this->shared_from_this())](error_code ec)
+        {
+          auto st = wp.lock();
+          if (ec || !st)
+            return;
+          st->health_check_running = false;
+          st->health_check();
+          if (!st->sessions.empty())
+            st->start_health_check();
+        });
+  }
+
+  void health_check()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<entry_type>> evicted;
+    for (auto & kv : sessions)
+      for (auto & e : kv.second)
+      {
+        if (!e->ready || e->channels > 0u)
+          continue;
+
+        const auto s = e->session.native_handle();
+        ssh_set_blocking(s, 0);
+        // processes whatever the server sent in the meantime, e.g. a disconnect.
+        ssh_blocking_flush(s, 0);
+        if (!ssh_is_connected(s) || (e->last_used + options.idle_timeout) < now)
+          evicted.push_back(e);
+        else
+          ssh_send_keepalive(s);
+      }
+    for (auto & e : evicted)
+      evict(e.get());
+  }
+};
+
+template<typename Executor>
+void session_pool_entry<Executor>::release_channel()
+{
+  channels--;
+  last_used = std::chrono::steady_clock::now();
+  if (broken || !ssh_is_connected(session.native_handle()))
+  {
+    broken = true;
+    if (auto p = pool.lock())
+      p->evict(this);
+  }
+  else if (auto p = pool.lock())
+    p->slot_signal.cancel();
+}
+
+}
+
+/// A channel handed out by a basic_session_pool, which returns its slot on destruction.
+template<typename Executor = net::any_io_executor>
+struct basic_pooled_channel
+{
+  typedef Executor executor_type;
+
+  basic_pooled_channel() = default;
+  basic_pooled_channel(basic_pooled_channel && lhs)
+      : entry_(std::move(lhs.entry_)), channel_(std::move(lhs.channel_))
+  {
+    lhs.channel_.reset();
+  }
+
+  basic_pooled_channel& operator=(basic_pooled_channel && lhs)
+  {
+    reset();
+    entry_ = std::move(lhs.entry_);
+    channel_ = std::move(lhs.channel_);
+    lhs.channel_.reset();
+    return *this;
+  }
+
+  ~basic_pooled_channel()
+  {
+    reset();
+  }
+
+  explicit operator bool() const {return channel_.has_value();}
+
+        basic_channel<executor_type> & operator*()        { return *channel_; }
+  const basic_channel<executor_type> & operator*()  const { return *channel_; }
+        basic_channel<executor_type> * operator->()       { return &*channel_; }
+  const basic_channel<executor_type> * operator->() const { return &*channel_; }
+
+  /// Close the channel & return its slot to the pool.
+  void reset()
+  {
+    channel_.reset();
+    if (entry_)
+      entry_->release_channel();
+    entry_.reset();
+  }
+
+ private:
+  template<typename>
+  friend struct basic_session_pool;
+
+  explicit basic_pooled_channel(std::shared_ptr<detail::session_pool_entry<executor_type>> entry)
+      : entry_(std::move(entry))
+  {
+    channel_.emplace(entry_->session);
+  }
+
+  std::shared_ptr<detail::session_pool_entry<executor_type>> entry_;
+  optional<basic_channel<executor_type>> channel_;
+};
+
+/// A pool of authenticated sessions keyed by host, port & user, that hands out fresh session channels.
+/** All sessions run on the executor of the pool, so use a strand if it runs on multiple threads.
+ * Sessions get connected through `async_connect`, i.e. with publickey auth and host key verification.
+ */
+template<typename Executor = net::any_io_executor>
+struct basic_session_pool
+{
+  /// The type of the executor associated with the object.
+  typedef Executor executor_type;
+
+  /// Rebinds the pool type to another executor.
+  template <typename Executor1>
+  struct rebind_executor
+  {
+    /// The pool type when rebound to the specified executor.
+    typedef basic_session_pool<Executor1> other;
+  };
+
+  using channel_type = basic_pooled_channel<executor_type>;
+
+  explicit basic_session_pool(const executor_type & ex, const session_pool_options & options = {})
+      : state_(std::make_shared<state_type>(ex, options))
+  {
+  }
+
+  template <typename ExecutionContext>
+  explicit basic_session_pool(ExecutionContext& context,
+                              const session_pool_options & options = {},
+                              typename std::enable_if<
+                                  std::is_convertible<ExecutionContext&, net::execution_context&>::value,
+                                  int>::type = 0)
+      : state_(std::make_shared<state_type>(context.get_executor(), options))
+  {
+  }
+
+  basic_session_pool(basic_session_pool && ) = default;
+  basic_session_pool& operator=(basic_session_pool && ) = default;
+
+  ~basic_session_pool()
+  {
+    if (state_)
+      close();
+  }
+
+  executor_type get_executor() noexcept
+  {
+    return state_->executor;
+  }
+
+  /// Get a freshly opened session channel to `key`, connecting a new session if needed.
+  template <ASIOFY_COMPLETION_TOKEN_FOR(void (error_code, channel_type)) AcquireToken
+              ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+  ASIOFY_INITFN_RESULT_TYPE(AcquireToken, void (error_code, channel_type))
+  async_acquire(session_key key, AcquireToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(executor_type))
+  {
+    return net::async_compose<AcquireToken, void (error_code, channel_type)>
+        (
+            acquire_op{{}, state_, std::move(key), nullptr, {}},
+            token, state_->slot_signal
+        );
+  }
+
+  /// The number of open sessions.
+  std::size_t size() const
+  {
+    std::size_t sz = 0u;
+    for (const auto & kv : state_->sessions)
+      sz += kv.second.size();
+    return sz;
+  }
+
+  /// Run the health check right away, instead of waiting for the interval.
+  void health_check()
+  {
+    state_->health_check();
+  }
+
+  /// Drop all sessions, channels that are in use keep their session alive until released.
+  /** Pending acquires complete with `operation_aborted`. */
+  void close()
+  {
+    error_code ec;
+    state_->closed = true;
+    state_->health_timer.cancel(ec);
+    state_->sessions.clear();
+    state_->slot_signal.cancel(ec);
+  }
+
+ private:
+  using state_type = detail::session_pool_state<executor_type>;
+  using entry_type = detail::session_pool_entry<executor_type>;
+
+  struct acquire_op : net::coroutine
+  {
+    std::shared_ptr<state_type> st;
+    session_key key;
+    std::shared_ptr<entry_type> entry;
+    channel_type channel;
+
+    template<typename Self>
+    void operator()(Self && self, error_code ec = {})
+    {
+      ASIOFY_CORO_REENTER(*this)
+      {
+        if (st->closed)
+          return abort(self);
+        st->start_health_check();
+        while (!(entry = st->reserve(key)))
+        {
+          // the timer never expires, it only gets cancelled when a slot frees up or the pool closes.
+          ASIOFY_CORO_YIELD st->slot_signal.async_wait(std::move(self));
+          if (st->closed)
+            return abort(self);
+        }
+
+        if (!entry->ready && !entry->connecting)
+        {
+          entry->connecting = true;
+          if (st->options.configure)
+            st->options.configure(entry->session.native_handle());
+          ASIOFY_CORO_YIELD async_connect(entry->session, key.host, key.port, key.user, std::move(self));
+          entry->connecting = false;
+          entry->ready  = !ec;
+          entry->broken = !!ec;
+          entry->error  = ec;
+          entry->ready_signal.cancel();
+        }
+        else
+          while (!entry->ready && !entry->broken)
+          {
+            ASIOFY_CORO_YIELD entry->ready_signal.async_wait(std::move(self));
+          }
+
+        if (st->closed)
+          return abort(self);
+        channel = channel_type{std::move(entry)};
+        if (channel.entry_->broken)
+        {
+          ec = channel.entry_->error;
+          channel.reset();
+          return self.complete(ec, std::move(channel));
+        }
+
+        ASIOFY_CORO_YIELD channel->async_open_session(std::move(self));
+        if (ec)
+          channel.reset();
+        self.complete(ec, std::move(channel));
+      }
+    }
+
+    template<typename Self>
+    void abort(Self & self)
+    {
+      entry.reset();
+      error_code ec;
+      ASIOFY_ASSIGN_EC(ec, net::error::operation_aborted, net::error::get_system_category());
+      self.complete(ec, channel_type{});
+    }
+  };
+
+  std::shared_ptr<state_type> state_;
+};
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_SESSION_POOL_HPP
@@ -9,17 +9,108 @@
 #define ASIOFY_WAIT_SOCKET_HPP
 
 #include <asiofy/libssh/detail/config.hpp>
+#if defined(ASIOFY_STANDALONE)
+#include <asio/basic_socket.hpp>
+#include <asio/any_io_executor.hpp>
+#else
 #include <boost/asio/basic_socket.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#endif
 
 namespace asiofy
 {
 namespace libssh
 {
 
-template<typename Socket>
-struct wait_socket : boost::asio::basic_socket<
+/// A socket that is used to wait for readiness of a file descriptor, which might be owned by someone else, i.e. libssh.
+/** Until `disown()` gets called, e.g. while it's being connected, it owns & closes its descriptor like any socket.
+ * After that, `drop` & the destructor only release it, so the owner can close it. */
+template<typename Protocol, typename Executor = net::any_io_executor>
+struct wait_socket : net::basic_socket<Protocol, Executor>
 {
+  using base_type = net::basic_socket<Protocol, Executor>;
+  using typename base_type::executor_type;
+  using typename base_type::native_handle_type;
 
+  /// Rebinds the socket type to another executor.
+  template <typename Executor1>
+  struct rebind_executor
+  {
+    /// The socket type when rebound to the specified executor.
+    typedef wait_socket<Protocol, Executor1> other;
+  };
+
+  explicit wait_socket(const executor_type & ex) : base_type(ex) {}
+
+  template <typename ExecutionContext>
+  explicit wait_socket(ExecutionContext& context,
+                       typename std::enable_if<
+                           std::is_convertible<ExecutionContext&, net::execution_context&>::value,
+                           int>::type = 0)
+      : base_type(context)
+  {
+  }
+
+  wait_socket(wait_socket && other) noexcept : base_type(std::move(other)), owned_(other.owned_)
+  {
+    other.owned_ = true;
+  }
+
+  wait_socket& operator=(wait_socket && other)
+  {
+    drop_();
+    base_type::operator=(std::move(other));
+    owned_ = other.owned_;
+    other.owned_ = true;
+    return *this;
+  }
+
+  // All wait_sockets have access to each other's ownership.
+  template <typename Protocol1, typename Executor1>
+  friend struct wait_socket;
+
+  template <typename Executor1>
+  wait_socket(wait_socket<Protocol, Executor1>&& other,
+              typename std::enable_if<
+                  std::is_convertible<Executor1, Executor>::value, int>::type = 0)
+      : base_type(std::move(other)), owned_(other.owned_)
+  {
+    other.owned_ = true;
+  }
+
+  /// The descriptor is owned by someone else from now on, so `drop` & the destructor only release it.
+  void disown() noexcept { owned_ = false; }
+
+  /// Whether the socket closes its descriptor, i.e. it hasn't been disowned.
+  bool owns_descriptor() const noexcept { return owned_; }
+
+  /// Let go of the descriptor: release it if it's disowned, close it otherwise.
+  /** Afterwards the socket is closed & owns whatever it opens next. */
+  void drop(error_code & ec)
+  {
+    if (this->is_open())
+    {
+      if (owned_)
+        this->close(ec);
+      else
+        this->release(ec);
+    }
+    owned_ = true;
+  }
+
+  ~wait_socket()
+  {
+    drop_();
+  }
+
+ private:
+  void drop_()
+  {
+    error_code ec;
+    drop(ec);
+  }
+
+  bool owned_ = true;
 };
 
 }
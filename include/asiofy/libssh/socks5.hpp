@@ -0,0 +1,244 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_SOCKS5_HPP
+#define ASIOFY_LIBSSH_SOCKS5_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/forward.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+// the parser works in place on a fixed buffer, so a connection doesn't allocate anything beyond itself.
+template<typename Executor>
+struct socks5_connection : forward_connection<Executor>
+{
+  using forward_connection<Executor>::forward_connection;
+
+  // the largest message is a request with a domain name: 4 + 1 + 255 + 2.
+  std::array<unsigned char, 262u> buffer;
+  char host[256];
+  int port = 0;
+  bool no_auth = false;
+  unsigned char reply = 0u;
+};
+
+template<typename Executor>
+struct socks5_connection_op : net::coroutine
+{
+  using connection_type = socks5_connection<Executor>;
+
+  std::shared_ptr<forward_state<Executor>> state;
+  std::unique_ptr<connection_type> conn;
+
+  enum : unsigned char
+  {
+    version          = 0x05,
+    method_no_auth   = 0x00,
+    no_methods       = 0xFF,
+    cmd_connect      = 0x01,
+    atyp_ipv4        = 0x01,
+    atyp_domain      = 0x03,
+    atyp_ipv6        = 0x04,
+    general_failure  = 0x01,
+    refused          = 0x05,
+    cmd_unsupported  = 0x07,
+    atyp_unsupported = 0x08
+  };
+
+  template<typename Self>
+  void operator()(Self && self, error_code ec = {}, std::size_t = 0u)
+  {
+    auto & c = *conn;
+    auto & buf = c.buffer;
+    ASIOFY_CORO_REENTER(*this)
+    {
+      // greeting: VER NMETHODS METHODS...
+      ASIOFY_CORO_YIELD net::async_read(c.socket, net::buffer(buf, 2u), std::move(self));
+      if (!ec && buf[0] != version)
+        protocol_error(ec);
+      if (!ec)
+      {
+        ASIOFY_CORO_YIELD net::async_read(c.socket, net::buffer(buf.data() + 2u, buf[1]), std::move(self));
+      }
+      if (!ec)
+      {
+        c.no_auth = std::find(buf.begin() + 2, buf.begin() + 2 + buf[1], method_no_auth) != buf.begin() + 2 + buf[1];
+        buf[0] = version;
+        buf[1] = c.no_auth ? method_no_auth : no_methods;
+        ASIOFY_CORO_YIELD net::async_write(c.socket, net::buffer(buf, 2u), std::move(self));
+      }
+      if (!ec && !c.no_auth)
+        protocol_error(ec);
+
+      // request: VER CMD RSV ATYP DST.ADDR DST.PORT
+      if (!ec)
+      {
+        ASIOFY_CORO_YIELD net::async_read(c.socket, net::buffer(buf, 4u), std::move(self));
+      }
+      if (!ec && buf[0] != version)
+        protocol_error(ec);
+      if (!ec)
+      {
+        if (buf[1] != cmd_connect)
+          c.reply = cmd_unsupported;
+        else if (buf[3] != atyp_ipv4 && buf[3] != atyp_domain && buf[3] != atyp_ipv6)
+          c.reply = atyp_unsupported;
+      }
+      if (!ec && c.reply == 0u && buf[3] == atyp_domain)
+      {
+        ASIOFY_CORO_YIELD net::async_read(c.socket, net::buffer(buf.data() + 4u, 1u), std::move(self));
+      }
+      if (!ec && c.reply == 0u)
+      {
+        ASIOFY_CORO_YIELD net::async_read(c.socket, net::buffer(buf.data() + address_offset(), address_size()),
+                                              std::move(self));
+      }
+      if (!ec && c.reply == 0u)
+      {
+        parse_address();
+        ASIOFY_CORO_YIELD c.channel.async_open_forward(c.host, c.port, c.source_host.c_str(), c.source_port,
+                                                           std::move(self));
+        if (ec)
+        {
+          c.reply = refused;
+          ec = {};
+        }
+      }
+
+      // reply: VER REP RSV ATYP BND.ADDR BND.PORT, the bound address is unknown, so it's all zeros.
+      if (!ec)
+      {
+        std::fill(buf.begin(), buf.begin() + 10, 0u);
+        buf[0] = version;
+        buf[1] = c.reply;
+        buf[3] = atyp_ipv4;
+        ASIOFY_CORO_YIELD net::async_write(c.socket, net::buffer(buf, 10u), std::move(self));
+      }
+
+      if (!ec && c.reply == 0u)
+      {
+        ASIOFY_CORO_YIELD async_bridge(c.channel, c.socket, state->options.buffer_size, std::move(self));
+      }
+
+      {
+        error_code ig;
+        error_info ei;
+        c.socket.close(ig);
+        if (c.channel.is_open())
+          c.channel.close(ig, ei);
+      }
+      state->connections--;
+      self.complete(ec);
+    }
+  }
+
+ private:
+  static void protocol_error(error_code & ec)
+  {
+    ASIOFY_ASSIGN_EC(ec, static_cast<int>(std::errc::protocol_error), generic_category());
+  }
+
+  std::size_t address_offset() const
+  {
+    return conn->buffer[3] == atyp_domain ? 5u : 4u;
+  }
+
+  // the address plus the port
+  std::size_t address_size() const
+  {
+    switch (conn->buffer[3])
+    {
+      case atyp_ipv4:   return 4u + 2u;
+      case atyp_ipv6:   return 16u + 2u;
+      case atyp_domain:
+      default:          return conn->buffer[4] + 2u;
+    }
+  }
+
+  void parse_address()
+  {
+    auto & c = *conn;
+    const unsigned char * p = c.buffer.data() + address_offset();
+    const std::size_t len = address_size() - 2u;
+    switch (c.buffer[3])
+    {
+      case atyp_ipv4:
+        std::snprintf(c.host, sizeof(c.host), "%u.%u.%u.%u", p[0], p[1], p[2], p[3]);
+        break;
+      case atyp_ipv6:
+        std::snprintf(c.host, sizeof(c.host), "%x:%x:%x:%x:%x:%x:%x:%x",
+                      (p[0]  << 8) | p[1],  (p[2]  << 8) | p[3],  (p[4]  << 8) | p[5],  (p[6]  << 8) | p[7],
+                      (p[8]  << 8) | p[9],  (p[10] << 8) | p[11], (p[12] << 8) | p[13], (p[14] << 8) | p[15]);
+        break;
+      default:
+        std::memcpy(c.host, p, len);
+        c.host[len] = '\0';
+    }
+    c.port = (p[len] << 8) | p[len + 1u];
+  }
+};
+
+}
+
+/// Run a SOCKS5 proxy on `acceptor`, that connects through direct-tcpip channels of `sess`.
+/** This is the equivalent of `ssh -D`. Only the CONNECT command without authentication is supported,
+ * the destination gets resolved by the server.
+ *
+ * The handshake gets parsed in a fixed buffer inside the per-connection state, so apart from that state & the
+ * buffers of the bridge, which are bounded by `options.buffer_size`, nothing gets allocated per connection.
+ * The token completes once the acceptor got closed or cancelled, other accept errors are retried.
+ */
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ForwardToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ForwardToken, void (error_code))
+async_forward_socks5(basic_session<Executor> & sess,
+                     net::basic_socket_acceptor<net::ip::tcp, Executor> & acceptor,
+                     const forward_options & options,
+                     ForwardToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  auto state = std::allocate_shared<detail::forward_state<Executor>>(
+      sess.get_allocator(), detail::forward_state<Executor>{sess, std::string{}, 0, options, false});
+  return net::async_compose<ForwardToken, void (error_code)>(
+      detail::forward_accept_op<Executor, detail::socks5_connection_op<Executor>>{{}, acceptor, std::move(state), nullptr},
+      token, acceptor);
+}
+
+template<typename Executor,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) ForwardToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(ForwardToken, void (error_code))
+async_forward_socks5(basic_session<Executor> & sess,
+                     net::basic_socket_acceptor<net::ip::tcp, Executor> & acceptor,
+                     ForwardToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return async_forward_socks5(sess, acceptor, forward_options{}, std::forward<ForwardToken>(token));
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_SOCKS5_HPP
@@ -0,0 +1,498 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_STATS_HPP
+#define ASIOFY_LIBSSH_STATS_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/detail/trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+/// The kinds of operation the session statistics are kept for.
+enum class op_kind
+{
+  connect,
+  accept,
+  key_exchange,
+  auth,
+  channel_open,
+  channel_request,
+  channel_read,
+  channel_write,
+  other
+};
+
+constexpr std::size_t op_kind_count = static_cast<std::size_t>(op_kind::other) + 1u;
+
+/// The name of an op_kind, e.g. for reports.
+inline const char * to_string(op_kind kind)
+{
+  switch (kind)
+  {
+    case op_kind::connect:         return "connect";
+    case op_kind::accept:          return "accept";
+    case op_kind::key_exchange:    return "key_exchange";
+    case op_kind::auth:            return "auth";
+    case op_kind::channel_open:    return "channel_open";
+    case op_kind::channel_request: return "channel_request";
+    case op_kind::channel_read:    return "channel_read";
+    case op_kind::channel_write:   return "channel_write";
+    case op_kind::other:           return "other";
+  }
+  return "unknown";
+}
+
+/// What the composed operations of one kind cost.
+struct op_stats
+{
+  /// The number of operations started.
+  std::uint64_t initiations = 0u;
+  /// The number of times libssh returned SSH_AGAIN, i.e. how often an operation had to wait again.
+  std::uint64_t retries = 0u;
+  /// The time spent waiting for the socket.
+  std::chrono::nanoseconds wait_time{0};
+  /// The time spent inside libssh.
+  std::chrono::nanoseconds call_time{0};
+};
+
+/// Statistics of a session, only kept if ASIOFY_LIBSSH_ENABLE_STATS is defined.
+/** The counters aren't atomic, they get updated on the session's executor & should be read there. */
+struct session_stats
+{
+  op_stats ops[op_kind_count];
+
+        op_stats & operator[](op_kind kind)       { return ops[static_cast<std::size_t>(kind)]; }
+  const op_stats & operator[](op_kind kind) const { return ops[static_cast<std::size_t>(kind)]; }
+
+  void reset() { *this = session_stats{}; }
+};
+
+/// The traffic of a channel, or of all the channels of a session. Always kept.
+/** The counters aren't atomic, they get updated on the session's executor & should be read there. */
+struct traffic_stats
+{
+  std::uint64_t bytes_in  = 0u;
+  std::uint64_t bytes_out = 0u;
+  /// The number of reads & writes that moved data. libssh doesn't expose its packets, this is the closest to it.
+  std::uint64_t reads  = 0u;
+  std::uint64_t writes = 0u;
+  /// How often a write found the peer's window exhausted & had to wait for it to be adjusted.
+  std::uint64_t window_stalls = 0u;
+  /// When the channel or session was created.
+  std::chrono::steady_clock::time_point created = std::chrono::steady_clock::now();
+  /// The time from `created` to the first byte read, zero until then.
+  std::chrono::nanoseconds time_to_first_byte{0};
+
+  void received(std::size_t n)
+  {
+    if (bytes_in == 0u && n > 0u)
+      time_to_first_byte = std::chrono::steady_clock::now() - created;
+    bytes_in += n;
+    reads++;
+  }
+
+  void sent(std::size_t n)
+  {
+    bytes_out += n;
+    writes++;
+  }
+
+  void stalled() { window_stalls++; }
+
+  /// Add up the counters, `created` & `time_to_first_byte` are kept.
+  traffic_stats & operator+=(const traffic_stats & other)
+  {
+    bytes_in      += other.bytes_in;
+    bytes_out     += other.bytes_out;
+    reads         += other.reads;
+    writes        += other.writes;
+    window_stalls += other.window_stalls;
+    return *this;
+  }
+};
+
+/// The traffic of many sessions or channels, e.g. all of a server's.
+struct traffic_snapshot
+{
+  /// The number of sessions or channels taken.
+  std::size_t count = 0u;
+  /// The sum of all their counters.
+  traffic_stats total;
+  /// The id & traffic of the ones that moved the most bytes, heaviest first.
+  std::vector<std::pair<std::uint64_t, traffic_stats>> heaviest;
+};
+
+namespace detail
+{
+
+inline unsigned msb(std::uint64_t value)
+{
+#if defined(__GNUC__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+  unsigned res = 0u;
+  while (value >>= 1u)
+    res++;
+  return res;
+#endif
+}
+
+}
+
+/// A log-linear histogram of latencies in nanoseconds, like HdrHistogram.
+/** The buckets get wider with the value, so any value is off by less than 1/16 from 1ns up to centuries.
+ * There may be one thread recording, which doesn't need atomic read-modify-writes for it,
+ * and any number of threads reading at the same time.
+ */
+class latency_histogram
+{
+ public:
+  constexpr static unsigned sub_bucket_bits = 5u;
+  constexpr static std::size_t bucket_count = (64u - sub_bucket_bits + 2u) << (sub_bucket_bits - 1u);
+
+  latency_histogram() = default;
+  latency_histogram(const latency_histogram &) = delete;
+  latency_histogram& operator=(const latency_histogram &) = delete;
+
+  /// Record one value, only one thread may do so at a time.
+  void record(std::chrono::nanoseconds value)
+  {
+    const auto ns = static_cast<std::uint64_t>((std::max)(value.count(), std::chrono::nanoseconds::rep(0)));
+    increment(counts_[bucket_of(ns)], 1u);
+    increment(count_, 1u);
+    increment(sum_, ns);
+    if (ns > max_.load(std::memory_order_relaxed))
+      max_.store(ns, std::memory_order_relaxed);
+  }
+
+  /// Add the values of another histogram, e.g. of another thread. Counts as recording.
+  void merge(const latency_histogram & other)
+  {
+    for (std::size_t i = 0u; i < bucket_count; i++)
+      increment(counts_[i], other.counts_[i].load(std::memory_order_relaxed));
+    increment(count_, other.count_.load(std::memory_order_relaxed));
+    increment(sum_,   other.sum_.load(std::memory_order_relaxed));
+    if (other.max() > max())
+      max_.store(other.max_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+  std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  std::chrono::nanoseconds max() const
+  {
+    return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+  }
+
+  std::chrono::nanoseconds mean() const
+  {
+    const auto n = count();
+    return std::chrono::nanoseconds(n == 0u ? 0u : sum_.load(std::memory_order_relaxed) / n);
+  }
+
+  /// The value at or below which `p` percent of the values lie, e.g. `percentile(99.9)`.
+  std::chrono::nanoseconds percentile(double p) const
+  {
+    const auto n = count();
+    if (n == 0u)
+      return std::chrono::nanoseconds(0);
+    auto rank = static_cast<std::uint64_t>(p / 100. * static_cast<double>(n) + .5);
+    rank = (std::max)(rank, std::uint64_t(1u));
+
+    std::uint64_t seen = 0u;
+    for (std::size_t i = 0u; i < bucket_count; i++)
+    {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen >= rank)
+        return (std::min)(std::chrono::nanoseconds(highest_of(i)), max());
+    }
+    return max();
+  }
+
+  static std::size_t bucket_of(std::uint64_t value)
+  {
+    if (value < (std::uint64_t(1u) << sub_bucket_bits))
+      return static_cast<std::size_t>(value);
+    const unsigned shift = detail::msb(value) - (sub_bucket_bits - 1u);
+    return (std::size_t(shift) << (sub_bucket_bits - 1u)) + static_cast<std::size_t>(value >> shift);
+  }
+
+  /// The highest value that falls into a bucket.
+  static std::uint64_t highest_of(std::size_t bucket)
+  {
+    if (bucket < (std::size_t(1u) << sub_bucket_bits))
+      return bucket;
+    const unsigned shift = static_cast<unsigned>(bucket >> (sub_bucket_bits - 1u)) - 1u;
+    const std::uint64_t top = bucket - (std::size_t(shift) << (sub_bucket_bits - 1u));
+    return ((top + 1u) << shift) - 1u;
+  }
+
+ private:
+  static void increment(std::atomic<std::uint64_t> & value, std::uint64_t n)
+  {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint64_t> counts_[bucket_count] = {};
+  std::atomic<std::uint64_t> count_{0u}, sum_{0u}, max_{0u};
+};
+
+/// An operation that took longer than the threshold of its latency_recorder.
+struct slow_op
+{
+  op_kind kind;
+  std::uint64_t session_id;
+  /// Zero if the operation isn't on a channel.
+  std::uint64_t channel_id;
+  std::chrono::nanoseconds duration;
+  error_code ec;
+};
+
+/// The latencies of the async operations per op_kind & a log of the slow ones.
+/** The operations record into the recorder installed on the thread they complete on,
+ * if ASIOFY_LIBSSH_ENABLE_STATS is defined. With several threads, install one per thread & merge them to report.
+ */
+class latency_recorder
+{
+ public:
+  /// Operations that take longer than `slow_threshold` get passed to `on_slow`,
+  /// on the recording thread, so it should be cheap.
+  explicit latency_recorder(std::chrono::nanoseconds slow_threshold = std::chrono::nanoseconds::max(),
+                            std::function<void(const slow_op &)> on_slow = {})
+      : slow_threshold_(slow_threshold), on_slow_(std::move(on_slow))
+  {
+  }
+
+  latency_recorder(const latency_recorder &) = delete;
+  latency_recorder& operator=(const latency_recorder &) = delete;
+
+  ~latency_recorder()
+  {
+    if (current_() == this)
+      current_() = nullptr;
+  }
+
+        latency_histogram & operator[](op_kind kind)       { return histograms_[static_cast<std::size_t>(kind)]; }
+  const latency_histogram & operator[](op_kind kind) const { return histograms_[static_cast<std::size_t>(kind)]; }
+
+  void record(op_kind kind, std::uint64_t session_id, std::uint64_t channel_id,
+              std::chrono::nanoseconds duration, const error_code & ec = {})
+  {
+    (*this)[kind].record(duration);
+    if (duration > slow_threshold_)
+    {
+      slow_count_.store(slow_count_.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+      if (on_slow_)
+        on_slow_(slow_op{kind, session_id, channel_id, duration, ec});
+    }
+  }
+
+  /// Add the histograms of another recorder.
+  void merge(const latency_recorder & other)
+  {
+    for (std::size_t i = 0u; i < op_kind_count; i++)
+      histograms_[i].merge(other.histograms_[i]);
+    slow_count_.store(slow_count() + other.slow_count(), std::memory_order_relaxed);
+  }
+
+  /// The number of operations above the threshold.
+  std::uint64_t slow_count() const { return slow_count_.load(std::memory_order_relaxed); }
+
+  /// Make this the recorder of the calling thread & return the previous one.
+  latency_recorder * install()
+  {
+    auto prev = current_();
+    current_() = this;
+    return prev;
+  }
+
+  /// The recorder of the calling thread, if any.
+  static latency_recorder * current() { return current_(); }
+
+ private:
+  static latency_recorder *& current_()
+  {
+    static thread_local latency_recorder * rec = nullptr;
+    return rec;
+  }
+
+  latency_histogram histograms_[op_kind_count];
+  std::chrono::nanoseconds slow_threshold_;
+  std::function<void(const slow_op &)> on_slow_;
+  std::atomic<std::uint64_t> slow_count_{0u};
+};
+
+namespace detail
+{
+
+// Ids of sessions & channels, unique in the process.
+inline std::uint64_t next_id()
+{
+  static std::atomic<std::uint64_t> id{0u};
+  return ++id;
+}
+
+template<typename T>
+auto traffic_source(const T & t) -> decltype(t.traffic(), &t)
+{
+  return &t;
+}
+
+template<typename Pointer>
+auto traffic_source(const Pointer & p) -> decltype((*p).traffic(), &*p)
+{
+  return &*p;
+}
+
+}
+
+/// Take a snapshot of the traffic of a range of sessions or channels, or of pointers to them.
+/** It copies the counters, so it needs to run on the executor they're used on.
+ * @param top The number of heaviest entries to keep.
+ */
+template<typename Range>
+traffic_snapshot snapshot_traffic(const Range & range, std::size_t top = 10u)
+{
+  traffic_snapshot res;
+  const auto heavier = [](const std::pair<std::uint64_t, traffic_stats> & lhs,
+                          const std::pair<std::uint64_t, traffic_stats> & rhs)
+  {
+    return lhs.second.bytes_in + lhs.second.bytes_out > rhs.second.bytes_in + rhs.second.bytes_out;
+  };
+
+  for (const auto & elem : range)
+  {
+    const auto src = detail::traffic_source(elem);
+    res.count++;
+    res.total += src->traffic();
+    if (top == 0u)
+      continue;
+
+    // a min-heap of the heaviest, so the lightest of them is the one to drop.
+    res.heaviest.emplace_back(src->id(), src->traffic());
+    std::push_heap(res.heaviest.begin(), res.heaviest.end(), heavier);
+    if (res.heaviest.size() > top)
+    {
+      std::pop_heap(res.heaviest.begin(), res.heaviest.end(), heavier);
+      res.heaviest.pop_back();
+    }
+  }
+  std::sort_heap(res.heaviest.begin(), res.heaviest.end(), heavier);
+  return res;
+}
+
+namespace detail
+{
+
+// The instrumentation of a composed op, which the op keeps across its waits.
+// Without ASIOFY_LIBSSH_ENABLE_STATS it's empty & all of it inlines to nothing.
+template<op_kind Kind>
+struct op_instrument
+{
+#if defined(ASIOFY_LIBSSH_ENABLE_STATS)
+  std::uint64_t channel_id = 0u;
+  std::chrono::steady_clock::time_point start, wait_start;
+
+  op_instrument(std::uint64_t channel_id = 0u) : channel_id(channel_id) {}
+
+  template<typename Session>
+  void initiated(Session & sess)
+  {
+    start = std::chrono::steady_clock::now();
+    sess.stats()[Kind].initiations++;
+  }
+
+  template<typename Session>
+  void finished(Session & sess, const error_code & ec)
+  {
+    if (auto rec = latency_recorder::current())
+      rec->record(Kind, sess.id(), channel_id, std::chrono::steady_clock::now() - start, ec);
+  }
+
+  template<typename Session>
+  void waiting(Session & sess, int wait_type)
+  {
+    ASIOFY_LIBSSH_TRACE_WAIT(sess.id(), Kind, wait_type);
+    wait_start = std::chrono::steady_clock::now();
+  }
+
+  template<typename Session>
+  void woken(Session & sess)
+  {
+    if (wait_start != std::chrono::steady_clock::time_point{})
+      sess.stats()[Kind].wait_time += std::chrono::steady_clock::now() - wait_start;
+  }
+
+  template<typename Session>
+  void retried(Session & sess)
+  {
+    sess.stats()[Kind].retries++;
+  }
+
+  template<typename Session, typename Func>
+  auto call(Session & sess, Func && func) -> decltype(func())
+  {
+    const auto call_start = std::chrono::steady_clock::now();
+    auto res = func();
+    sess.stats()[Kind].call_time += std::chrono::steady_clock::now() - call_start;
+    ASIOFY_LIBSSH_TRACE_CALL(sess.id(), Kind, res, bytes_of(res));
+    return res;
+  }
+#else
+  op_instrument(std::uint64_t = 0u) {}
+
+  template<typename Session> void initiated(Session &) {}
+  template<typename Session> void finished(Session &, const error_code &) {}
+  template<typename Session>
+  void waiting(Session & sess, int wait_type)
+  {
+    ASIOFY_LIBSSH_TRACE_WAIT(sess.id(), Kind, wait_type);
+  }
+
+  template<typename Session> void woken(Session &) {}
+  template<typename Session> void retried(Session &) {}
+
+  template<typename Session, typename Func>
+  auto call(Session & sess, Func && func) -> decltype(func())
+  {
+    auto res = func();
+    ASIOFY_LIBSSH_TRACE_CALL(sess.id(), Kind, res, bytes_of(res));
+    return res;
+  }
+#endif
+
+  // the channel reads & writes return the bytes transferred.
+  constexpr static int bytes_of(int res)
+  {
+    return (Kind == op_kind::channel_read || Kind == op_kind::channel_write) && res > 0 ? res : 0;
+  }
+
+  template<typename Session, typename Self, typename ... Args>
+  void complete(Session & sess, Self & self, error_code ec, Args && ... args)
+  {
+    finished(sess, ec);
+    self.complete(ec, std::forward<Args>(args)...);
+  }
+};
+
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_STATS_HPP
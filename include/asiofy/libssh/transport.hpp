@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_LIBSSH_TRANSPORT_HPP
+#define ASIOFY_LIBSSH_TRANSPORT_HPP
+
+#include <asiofy/libssh/detail/config.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/detail/pump.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/local/connect_pair.hpp>
+#include <asio/local/stream_protocol.hpp>
+#include <asio/post.hpp>
+#else
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#endif
+
+#include <memory>
+
+namespace asiofy
+{
+namespace libssh
+{
+namespace detail
+{
+
+template<typename Executor>
+struct initiate_async_run_transport
+{
+  template<typename Handler, typename Stream>
+  void operator()(Handler && handler, basic_session<Executor> * sess, Stream * stream, std::size_t buffer_size)
+  {
+    // the end of the socketpair that libssh doesn't see is the first end of the pump.
+    using socket_type = net::basic_stream_socket<net::local::stream_protocol, Executor>;
+    using state_type = pump_state<Executor, socket_type, typename pump_end<Stream>::type,
+                                  typename std::decay<Handler>::type>;
+    auto st = std::allocate_shared<state_type>(sess->get_allocator(), sess->get_executor(), sess->get_allocator(),
+                                               socket_type{sess->get_executor()}, pump_end<Stream>::make(*stream),
+                                               buffer_size, std::forward<Handler>(handler));
+
+    error_code ec;
+    socket_type peer{sess->get_executor()};
+    net::local::connect_pair(st->first, peer, ec);
+    if (!ec)
+    {
+      const auto fd = peer.release(ec);
+      if (!ec)
+        sess->next_layer().assign(net::generic::stream_protocol(net::local::stream_protocol()), fd, ec);
+    }
+    if (ec)
+    {
+      st->pending = 1;
+      return net::post(sess->get_executor(), [st, ec]{ st->done(ec); });
+    }
+    start_pump(st);
+  }
+};
+
+}
+
+/// Run `sess` over any asio stream, e.g. a TLS or websocket stream or a channel of another session.
+/** libssh only reads from & writes to a file descriptor, so the session gets one end of a socketpair as its
+ * `next_layer()` and the other end gets pumped to and from `stream` with two fixed buffers of `buffer_size`.
+ * After initiating this, the session can be used as usual, starting with `async_connect`.
+ *
+ * A `basic_channel` is pumped through its stdout, with its eof forwarded by `send_eof`, like in `async_bridge`.
+ *
+ * The token completes once both directions are done, i.e. the stream or the session closed.
+ * The stream must use the executor of the session, or one that runs on the same thread.
+ */
+template<typename Executor, typename Stream,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RunToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(RunToken, void (error_code))
+async_run_transport(basic_session<Executor> & sess, Stream & stream, std::size_t buffer_size,
+                    RunToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_initiate<RunToken, void(error_code)>(
+      detail::initiate_async_run_transport<Executor>{}, token, &sess, &stream, buffer_size);
+}
+
+template<typename Executor, typename Stream,
+         ASIOFY_COMPLETION_TOKEN_FOR(void (error_code)) RunToken
+           ASIOFY_DEFAULT_COMPLETION_TOKEN_TYPE(Executor)>
+ASIOFY_INITFN_RESULT_TYPE(RunToken, void (error_code))
+async_run_transport(basic_session<Executor> & sess, Stream & stream,
+                    RunToken && token ASIOFY_DEFAULT_COMPLETION_TOKEN(Executor))
+{
+  return net::async_initiate<RunToken, void(error_code)>(
+      detail::initiate_async_run_transport<Executor>{}, token, &sess, &stream, std::size_t(32768u));
+}
+
+}
+}
+
+#endif //ASIOFY_LIBSSH_TRANSPORT_HPP
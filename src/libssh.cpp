@@ -4,3 +4,25 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+
+// The compiled part of asiofy::libssh, built as the asiofy_libssh library with ASIOFY_SEPARATE_COMPILATION.
+
+#include <asiofy/libssh/src.hpp>
+
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/bind.hpp>
+#include <asiofy/libssh/server.hpp>
+
+namespace asiofy
+{
+namespace libssh
+{
+
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_SESSION, )
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_CHANNEL, )
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_BIND, )
+ASIOFY_LIBSSH_FOR_EACH_EXECUTOR(ASIOFY_LIBSSH_INSTANTIATE_SERVER, )
+
+}
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/arena.hpp>
+
+#if defined(ASIOFY_HAS_PMR)
+
+#include "loopback.hpp"
+#include "doctest.h"
+
+#include <memory>
+
+using namespace asiofy::libssh;
+
+namespace
+{
+
+// counts what the arenas take from upstream.
+struct counting_resource final : std::pmr::memory_resource
+{
+  std::size_t allocations = 0u;
+  std::size_t outstanding = 0u;
+
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    allocations++;
+    outstanding += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+  {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("arena");
+
+TEST_CASE("session_arena reuses memory and releases it at once")
+{
+  counting_resource upstream;
+  {
+    session_arena arena{1024u, &upstream};
+    const auto round = [&]
+    {
+      for (int i = 0; i < 1000; i++)
+      {
+        void * p = arena.allocate(128u);
+        arena.deallocate(p, 128u);
+      }
+    };
+    round();
+    const auto after_first = upstream.allocations;
+    CHECK(after_first > 0u);
+    CHECK(upstream.outstanding > 0u);
+
+    // the memory given back gets reused, so nothing more comes from upstream.
+    round();
+    CHECK(upstream.allocations == after_first);
+
+    arena.release();
+    CHECK(upstream.outstanding == 0u);
+    CHECK(arena.allocate(16u) != nullptr);
+  }
+  CHECK(upstream.outstanding == 0u);
+}
+
+TEST_CASE("session operations allocate from the arena")
+{
+  counting_resource upstream;
+  {
+    loopback lb;
+    lb.client.set_memory_resource(std::make_unique<session_arena>(4096u, &upstream));
+    lb.server.set_memory_resource(std::make_unique<session_arena>(4096u, &upstream));
+    CHECK(lb.client.get_allocator().resource() == lb.client.memory_resource());
+
+    lb.connect();
+    auto chan = lb.open_channel();
+    CHECK(upstream.allocations > 0u);
+    CHECK(upstream.outstanding > 0u);
+  }
+  CHECK(upstream.outstanding == 0u);
+}
+
+TEST_SUITE_END();
+
+#endif
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/bridge.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+
+namespace
+{
+
+struct bridged
+{
+  loopback lb;
+  loopback::channel_type chan;
+  loopback::channel_type & peer;
+  loopback::channel_type::stdreader peer_stream;
+  net::local::stream_protocol::socket local{lb.ctx}, remote{lb.ctx};
+
+  error_code result;
+  bool done = false;
+
+  static loopback::channel_type connect(loopback & lb)
+  {
+    lb.connect();
+    return lb.open_channel();
+  }
+
+  bridged() : chan(connect(lb)), peer(lb.server_channels.front()), peer_stream(peer.get_stdout())
+  {
+    net::local::connect_pair(local, remote);
+    asiofy::libssh::async_bridge(chan, local, 1024u, [this](error_code ec) { result = ec; done = true; });
+  }
+
+  template<typename Source, typename Sink>
+  std::string transfer(Source & source, Sink & sink, const std::string & data)
+  {
+    std::string buf(data.size(), '\0');
+    int pending = 2;
+    net::async_write(source, net::buffer(data), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    net::async_read(sink, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    return buf;
+  }
+
+  template<typename Stream>
+  error_code read_eof(Stream & stream)
+  {
+    char c;
+    error_code res;
+    bool read = false;
+    stream.async_read_some(net::buffer(&c, 1u), [&](error_code ec, std::size_t) { res = ec; read = true; });
+    lb.run_until([&]{ return read; });
+    return res;
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("bridge");
+
+TEST_CASE("async_bridge pumps both directions until both sent eof")
+{
+  bridged b;
+  CHECK(b.transfer(b.remote, b.peer_stream, "ping") == "ping");
+  CHECK(b.transfer(b.peer_stream, b.remote, "pong") == "pong");
+
+  // an eof of the stream gets forwarded to the channel.
+  b.remote.shutdown(net::socket_base::shutdown_send);
+  CHECK(b.read_eof(b.peer_stream) == net::error::eof);
+  CHECK(!b.done);
+
+  // and one of the channel to the stream, which ends the bridge.
+  b.peer.async_send_eof([](error_code ec) { CHECK(!ec); });
+  CHECK(b.read_eof(b.remote) == net::error::eof);
+  b.lb.run_until([&]{ return b.done; });
+  CHECK(!b.result);
+}
+
+TEST_CASE("async_bridge closes the channel when the stream fails")
+{
+  bridged b;
+  CHECK(b.transfer(b.remote, b.peer_stream, "ping") == "ping");
+
+  // the stream reads an eof first, then the write of the next data fails.
+  b.remote.close();
+  CHECK(b.read_eof(b.peer_stream) == net::error::eof);
+  b.peer.async_write_some(net::buffer("data", 4u), false, [](error_code ec, std::size_t) { CHECK(!ec); });
+  b.lb.run_until([&]{ return b.done; });
+
+  CHECK(b.result == net::error::broken_pipe);
+  CHECK(!b.chan.is_open());
+}
+
+TEST_CASE("async_bridge can be cancelled through the stream")
+{
+  bridged b;
+  b.local.cancel();
+
+  // the server sees the channel go away & closes its end as well, like sshd does.
+  CHECK(b.read_eof(b.peer_stream) == net::error::eof);
+  b.peer.close();
+  b.lb.run_until([&]{ return b.done; });
+
+  CHECK(b.result == net::error::operation_aborted);
+  CHECK(!b.local.is_open());
+  CHECK(!b.chan.is_open());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/buffer_pool.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#include <cstring>
+
+using namespace asiofy::libssh;
+
+TEST_SUITE_BEGIN("buffer_pool");
+
+TEST_CASE("buffer_pool reuses buffers")
+{
+  buffer_pool pool{64u, 1u};
+  {
+    auto a = pool.acquire();
+    CHECK(a.size() == 64u);
+    CHECK(a.capacity() == 64u);
+    a.resize(3u);
+    CHECK(a.size() == 3u);
+
+    auto copy = a;
+    CHECK(a.use_count() == 2u);
+    CHECK(copy.data() == a.data());
+    a.reset();
+    CHECK(!a);
+    CHECK(pool.in_use() == 1u);
+    CHECK(pool.idle() == 0u);
+
+    auto b = pool.acquire();
+    CHECK(pool.created() == 2u);
+  }
+  // one more than the pool keeps got freed.
+  CHECK(pool.in_use() == 0u);
+  CHECK(pool.idle() == 1u);
+
+  auto c = pool.acquire();
+  CHECK(c.size() == 64u);
+  CHECK(c.use_count() == 1u);
+  CHECK(pool.reused() == 1u);
+
+  pool.reserve(4u);
+  CHECK(pool.idle() == 1u);
+  pool.shrink();
+  CHECK(pool.idle() == 0u);
+}
+
+TEST_CASE("channel reads into pooled buffers")
+{
+  loopback lb;
+  lb.connect();
+  auto chan = lb.open_channel();
+  REQUIRE(lb.server_channels.size() == 1u);
+  auto & peer = lb.server_channels.front();
+
+  buffer_pool pool{1024u};
+  const char ping[] = "ping";
+  asiofy::libssh::error_code write_ec, read_ec;
+  pooled_buffer received;
+  int pending = 2;
+
+  // the read is started first, so it waits without holding a buffer.
+  peer.async_read_some(pool, false,
+                       [&](asiofy::libssh::error_code ec, pooled_buffer buf)
+                       {
+                         read_ec = ec;
+                         received = std::move(buf);
+                         pending--;
+                       });
+  CHECK(pool.in_use() == 0u);
+  chan.async_write_some(net::buffer(ping), false,
+                        [&](asiofy::libssh::error_code ec, std::size_t) { write_ec = ec; pending--; });
+  lb.run_until([&]{ return pending == 0; });
+
+  CHECK(!write_ec);
+  CHECK(!read_ec);
+  REQUIRE(received.size() == sizeof(ping));
+  CHECK(std::memcmp(received.data(), ping, sizeof(ping)) == 0);
+  CHECK(pool.in_use() == 1u);
+  CHECK(peer.traffic().bytes_in == sizeof(ping));
+
+  received.reset();
+  CHECK(pool.in_use() == 0u);
+  CHECK(pool.idle() == 1u);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/fan_out.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#else
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#endif
+
+#include <map>
+
+#include <dirent.h>
+
+using namespace asiofy::libssh;
+namespace net = asiofy::net;
+
+namespace
+{
+
+// the number of descriptors the process has open.
+std::size_t open_fds()
+{
+  std::size_t n = 0u;
+  if (DIR * dir = ::opendir("/proc/self/fd"))
+  {
+    while (::readdir(dir) != nullptr)
+      n++;
+    ::closedir(dir);
+  }
+  return n;
+}
+
+// answers an exec by echoing the command, followed by exit status 3, or never if `stall` is set.
+void serve_exec(loopback & lb, bool stall = false)
+{
+  lb.on_message = [stall](loopback::session_type &, ssh_message msg)
+  {
+    if (ssh_message_type(msg) != SSH_REQUEST_CHANNEL || ssh_message_subtype(msg) != SSH_CHANNEL_REQUEST_EXEC)
+      return false;
+    ssh_message_channel_request_reply_success(msg);
+    if (stall)
+      return true;
+
+    const auto chan = ssh_message_channel_request_channel(msg);
+    const std::string cmd = ssh_message_channel_request_command(msg);
+    ssh_channel_write(chan, cmd.data(), static_cast<std::uint32_t>(cmd.size()));
+    ssh_channel_request_send_exit_status(chan, 3);
+    ssh_channel_send_eof(chan);
+    return true;
+  };
+}
+
+}
+
+TEST_SUITE_BEGIN("fan_out");
+
+TEST_CASE("fan_out closes the sockets of unreachable hosts")
+{
+  net::io_context ctx;
+  const auto localhost = net::ip::make_address("127.0.0.1");
+
+  // never accepts, so the tcp connect succeeds, but the key exchange hangs until the deadline.
+  net::ip::tcp::acceptor silent{ctx, net::ip::tcp::endpoint(localhost, 0u)};
+  // a port that just got closed, so connecting to it gets refused.
+  unsigned short refused_port;
+  {
+    net::ip::tcp::acceptor closed{ctx, net::ip::tcp::endpoint(localhost, 0u)};
+    refused_port = closed.local_endpoint().port();
+  }
+
+  std::vector<exec_target> targets;
+  for (int i = 0; i < 16; i++)
+    targets.push_back({"127.0.0.1", refused_port, "nobody"});
+  for (int i = 0; i < 4; i++)
+    targets.push_back({"127.0.0.1", silent.local_endpoint().port(), "nobody"});
+
+  exec_fan_out_options options;
+  options.max_in_flight = 4u;
+  options.deadline = std::chrono::milliseconds(100);
+
+  std::size_t refused = 0u, timed_out = 0u, output = 0u;
+  const auto run = [&]
+  {
+    bool done = false;
+    async_exec_fan_out(ctx.get_executor(), targets, "true", options,
+                       [&](std::size_t, bool, net::const_buffer) { output++; },
+                       [&](std::size_t, error_code ec, int)
+                       {
+                         if (ec == net::error::connection_refused)
+                           refused++;
+                         else if (ec == net::error::timed_out)
+                           timed_out++;
+                       },
+                       [&](error_code) { done = true; });
+    ctx.restart();
+    ctx.run();
+    CHECK(done);
+  };
+
+  // the first round opens what the io_context & the resolver create lazily.
+  run();
+  const auto fds = open_fds();
+  run();
+  CHECK(open_fds() == fds);
+
+  CHECK(refused == 32u);
+  CHECK(timed_out == 8u);
+  CHECK(output == 0u);
+}
+
+TEST_CASE("fan_out runs the command on every host")
+{
+  loopback lb;
+  serve_exec(lb);
+  const auto port = lb.listen();
+
+  unsigned short refused_port;
+  {
+    net::ip::tcp::acceptor closed{lb.ctx, net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u)};
+    refused_port = closed.local_endpoint().port();
+  }
+
+  std::vector<exec_target> targets(3u, exec_target{"127.0.0.1", port, "nobody"});
+  targets.push_back({"127.0.0.1", refused_port, "nobody"});
+
+  exec_fan_out_options options;
+  options.max_in_flight = 2u;
+  options.configure = [&](ssh_session sess) { lb.trust(sess, "127.0.0.1", port); };
+
+  std::map<std::size_t, std::string> output;
+  std::map<std::size_t, std::pair<error_code, int>> exits;
+  bool done = false;
+  async_exec_fan_out(lb.ctx.get_executor(), targets, "echo hi", options,
+                     [&](std::size_t idx, bool is_stderr, net::const_buffer data)
+                     {
+                       CHECK(!is_stderr);
+                       output[idx].append(static_cast<const char*>(data.data()), data.size());
+                     },
+                     [&](std::size_t idx, error_code ec, int status) { exits[idx] = {ec, status}; },
+                     [&](error_code) { done = true; });
+  lb.run_until([&]{ return done; });
+
+  REQUIRE(exits.size() == 4u);
+  for (std::size_t idx = 0u; idx < 3u; idx++)
+  {
+    CHECK(!exits[idx].first);
+    CHECK(exits[idx].second == 3);
+    CHECK(output[idx] == "echo hi");
+  }
+  CHECK(exits[3u].first == net::error::connection_refused);
+  CHECK(output.count(3u) == 0u);
+  CHECK(lb.accepted.size() == 3u);
+}
+
+TEST_CASE("fan_out aborts a command that runs past the deadline")
+{
+  loopback lb;
+  serve_exec(lb, true);
+  const auto port = lb.listen();
+
+  const std::vector<exec_target> targets(2u, exec_target{"127.0.0.1", port, "nobody"});
+  exec_fan_out_options options;
+  options.deadline = std::chrono::milliseconds(200);
+  options.configure = [&](ssh_session sess) { lb.trust(sess, "127.0.0.1", port); };
+
+  std::size_t timed_out = 0u;
+  bool done = false;
+  async_exec_fan_out(lb.ctx.get_executor(), targets, "sleep 3600", options,
+                     [&](std::size_t, bool, net::const_buffer) {},
+                     [&](std::size_t, error_code ec, int status)
+                     {
+                       CHECK(status == -1);
+                       if (ec == net::error::timed_out)
+                         timed_out++;
+                     },
+                     [&](error_code) { done = true; });
+  lb.run_until([&]{ return done; });
+
+  CHECK(timed_out == 2u);
+  // the channels got as far as the exec.
+  CHECK(lb.server_channels.size() == 2u);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/forward.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+using acceptor_type = net::basic_socket_acceptor<net::ip::tcp, net::io_context::executor_type>;
+
+namespace
+{
+
+struct forwarded
+{
+  loopback lb;
+  acceptor_type acceptor{lb.ctx.get_executor(),
+                         net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u)};
+  std::string destination;
+  int destination_port = 0;
+  bool refuse = false;
+
+  error_code result;
+  bool done = false;
+
+  forwarded()
+  {
+    lb.on_message = [this](loopback::session_type &, ssh_message msg)
+    {
+      if (ssh_message_type(msg) != SSH_REQUEST_CHANNEL_OPEN || ssh_message_subtype(msg) != SSH_CHANNEL_DIRECT_TCPIP)
+        return false;
+      destination = ssh_message_channel_request_open_destination(msg);
+      destination_port = ssh_message_channel_request_open_destination_port(msg);
+      if (!refuse)
+        return false;
+      ssh_message_reply_default(msg);
+      return true;
+    };
+    lb.connect();
+    asiofy::libssh::async_forward_local(lb.client, acceptor, "example.org", 80,
+                                        [this](error_code ec) { result = ec; done = true; });
+  }
+
+  // the forwarded connections hold channels of the client session, so they need to finish before it's gone.
+  // the sockets of the test are closed by now, closing the server ends finishes the other direction.
+  ~forwarded()
+  {
+    error_code ig;
+    asiofy::libssh::error_info ei;
+    acceptor.close(ig);
+    for (auto & chan : lb.server_channels)
+      if (chan.is_open())
+        chan.close(ig, ei);
+    lb.ctx.restart();
+    lb.ctx.run_for(std::chrono::milliseconds(200));
+  }
+
+  net::ip::tcp::socket connect()
+  {
+    net::ip::tcp::socket sock{lb.ctx};
+    sock.connect(acceptor.local_endpoint());
+    return sock;
+  }
+
+  // the stream of the server end of the `n`th forwarded connection, once it's open.
+  loopback::channel_type::stdreader peer(std::size_t n)
+  {
+    lb.run_until([&]{ return lb.server_channels.size() > n; });
+    return lb.server_channels[n].get_stdout();
+  }
+
+  template<typename Source, typename Sink>
+  std::string transfer(Source & source, Sink & sink, const std::string & data)
+  {
+    std::string buf(data.size(), '\0');
+    int pending = 2;
+    net::async_write(source, net::buffer(data), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    net::async_read(sink, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    return buf;
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("forward");
+
+TEST_CASE("async_forward_local forwards every connection through its own channel")
+{
+  forwarded fw;
+  auto first = fw.connect();
+  auto first_peer = fw.peer(0u);
+  CHECK(fw.destination == "example.org");
+  CHECK(fw.destination_port == 80);
+  CHECK(fw.transfer(first, first_peer, "request") == "request");
+  CHECK(fw.transfer(first_peer, first, "response") == "response");
+
+  auto second = fw.connect();
+  auto second_peer = fw.peer(1u);
+  CHECK(fw.transfer(second, second_peer, "again") == "again");
+  CHECK(fw.lb.server_channels.size() == 2u);
+  CHECK(!fw.done);
+}
+
+TEST_CASE("async_forward_local closes a connection the server refuses")
+{
+  forwarded fw;
+  fw.refuse = true;
+  auto sock = fw.connect();
+
+  char c;
+  error_code read_ec;
+  bool read = false;
+  sock.async_read_some(net::buffer(&c, 1u), [&](error_code ec, std::size_t) { read_ec = ec; read = true; });
+  fw.lb.run_until([&]{ return read; });
+
+  CHECK(read_ec == net::error::eof);
+  CHECK(fw.destination == "example.org");
+  CHECK(fw.lb.server_channels.empty());
+  // the forward itself keeps accepting.
+  CHECK(!fw.done);
+}
+
+TEST_CASE("async_forward_local ends when the acceptor gets closed")
+{
+  forwarded fw;
+  auto sock = fw.connect();
+  auto peer = fw.peer(0u);
+  CHECK(fw.transfer(sock, peer, "before") == "before");
+
+  fw.acceptor.close();
+  fw.lb.run_until([&]{ return fw.done; });
+  CHECK(fw.result == net::error::operation_aborted);
+
+  // connections that are already open keep forwarding.
+  CHECK(fw.transfer(peer, sock, "after") == "after");
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/handle_pool.hpp>
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/generic/stream_protocol.hpp>
+#include <asio/io_context.hpp>
+#else
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/io_context.hpp>
+#endif
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace asiofy::libssh;
+
+TEST_SUITE_BEGIN("handle_pool");
+
+TEST_CASE("session_handle_pool reuses sessions")
+{
+  session_handle_pool pool{2u};
+  ssh_session first = nullptr;
+  {
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    first = c.get(); // destroyed first, so it gets pooled
+    CHECK(pool.created() == 3u);
+    CHECK(pool.idle() == 0u);
+  }
+  // one more than the pool keeps got freed.
+  CHECK(pool.idle() == 2u);
+
+  auto a = pool.acquire();
+  auto b = pool.acquire();
+  CHECK((a.get() == first || b.get() == first));
+  CHECK(pool.reused() == 2u);
+  CHECK(pool.created() == 3u);
+
+  session_handle plain{ssh_new()};
+  plain.reset();
+  CHECK(pool.idle() == 0u);
+}
+
+TEST_CASE("session_handle_pool reserve")
+{
+  session_handle_pool pool{4u};
+  pool.reserve(8u);
+  CHECK(pool.idle() == 4u);
+  CHECK(pool.created() == 4u);
+  {
+    asiofy::net::io_context ctx;
+    io_session sess{ctx, pool.acquire()};
+    CHECK(pool.idle() == 3u);
+    CHECK(sess.options_set(SSH_OPTIONS_HOST, "localhost"));
+  }
+  CHECK(pool.idle() == 4u);
+  CHECK(pool.reused() == 1u);
+}
+
+TEST_CASE("session_handle_pool applies its options on acquire")
+{
+  session_handle_pool pool{make_options(options::user{"pooled"}, options::port{2222u}), 1u};
+  ssh_session first = nullptr;
+  {
+    auto sess = pool.acquire();
+    first = sess.get();
+    CHECK(ssh_options_set(sess.get(), SSH_OPTIONS_USER, "someone") == SSH_OK);
+    CHECK(ssh_options_set(sess.get(), SSH_OPTIONS_PORT_STR, "22") == SSH_OK);
+    CHECK(ssh_options_set(sess.get(), SSH_OPTIONS_HOST, "example.org") == SSH_OK);
+  }
+
+  auto sess = pool.acquire();
+  REQUIRE(sess.get() == first);
+
+  char * value = nullptr;
+  REQUIRE(ssh_options_get(sess.get(), SSH_OPTIONS_USER, &value) == SSH_OK);
+  CHECK(std::string(value) == "pooled");
+  ssh_string_free_char(value);
+
+  unsigned port = 0u;
+  REQUIRE(ssh_options_get_port(sess.get(), &port) == SSH_OK);
+  CHECK(port == 2222u);
+
+  // options outside of the set survive.
+  REQUIRE(ssh_options_get(sess.get(), SSH_OPTIONS_HOST, &value) == SSH_OK);
+  CHECK(std::string(value) == "example.org");
+  ssh_string_free_char(value);
+}
+
+TEST_CASE("session_handle_pool with an assigned next_layer")
+{
+  namespace net = asiofy::net;
+  session_handle_pool pool{1u};
+  net::io_context ctx;
+  const net::generic::stream_protocol unix_stream{AF_UNIX, SOCK_STREAM};
+
+  int fds[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  asiofy::error_code wait_ec;
+  {
+    io_session sess{ctx, pool.acquire()};
+    sess.next_layer().assign(unix_stream, fds[0]);
+    CHECK(sess.options_set(SSH_OPTIONS_FD, fds[0]));
+    sess.next_layer().disown();
+    sess.next_layer().async_wait(net::socket_base::wait_read, [&](asiofy::error_code ec) { wait_ec = ec; });
+  }
+  // the socket got released, before the pool disconnected the session.
+  ctx.run();
+  CHECK(wait_ec == net::error::operation_aborted);
+  CHECK(pool.idle() == 1u);
+  if (::fcntl(fds[0], F_GETFD) != -1)
+    ::close(fds[0]);
+  ::close(fds[1]);
+
+  // a new socket, likely with the same fd, still gets its events from the reactor.
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  net::generic::stream_protocol::socket next{ctx, unix_stream, fds[0]};
+  wait_ec = net::error::operation_aborted;
+  next.async_wait(net::socket_base::wait_read, [&](asiofy::error_code ec) { wait_ec = ec; });
+  CHECK(::send(fds[1], "x", 1, 0) == 1);
+  ctx.restart();
+  ctx.run();
+  CHECK(!wait_ec);
+  ::close(fds[1]);
+}
+
+TEST_SUITE_END();
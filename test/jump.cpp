@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/jump.hpp>
+#include <asiofy/libssh/bridge.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+
+namespace
+{
+
+// the loopback server is the jump host, every direct-tcpip channel it accepts gets bridged into another server
+// session of the same bind, which is the target.
+struct jumped
+{
+  loopback lb;
+  std::deque<net::local::stream_protocol::socket> tunnel_ends;
+  std::deque<loopback::session_type> target_servers;
+  loopback::session_type target{lb.ctx.get_executor()};
+
+  std::string destination;
+  int destination_port = 0;
+  bool refuse = false;
+
+  jumped()
+  {
+    lb.on_message = [this](loopback::session_type & sess, ssh_message msg)
+    {
+      if (ssh_message_type(msg) != SSH_REQUEST_CHANNEL_OPEN || ssh_message_subtype(msg) != SSH_CHANNEL_DIRECT_TCPIP)
+        return false;
+      destination = ssh_message_channel_request_open_destination(msg);
+      destination_port = ssh_message_channel_request_open_destination_port(msg);
+      if (refuse)
+      {
+        ssh_message_reply_default(msg);
+        return true;
+      }
+      if (ssh_channel chan = ssh_message_channel_request_open_reply_accept(msg))
+        start_target(sess, chan);
+      return true;
+    };
+    lb.connect();
+  }
+
+  // the bridges hold channels of the jump session, so they need to finish before it's gone,
+  // and the channels of the target servers need to go before them.
+  ~jumped()
+  {
+    target.disconnect();
+    error_code ig;
+    asiofy::libssh::error_info ei;
+    for (auto & chan : lb.server_channels)
+      if (chan.is_open())
+        chan.close(ig, ei);
+    lb.ctx.restart();
+    lb.ctx.run_for(std::chrono::milliseconds(200));
+    lb.server_channels.clear();
+  }
+
+  void start_target(loopback::session_type & sess, ssh_channel chan)
+  {
+    lb.server_channels.emplace_back(sess, chan);
+    tunnel_ends.emplace_back(lb.ctx);
+    target_servers.emplace_back(lb.ctx.get_executor());
+    auto & server = target_servers.back();
+
+    net::local::stream_protocol::socket server_end{lb.ctx};
+    net::local::connect_pair(tunnel_ends.back(), server_end);
+    lb.bind.accept_fd(server, server_end.release());
+
+    asiofy::libssh::async_bridge(lb.server_channels.back(), tunnel_ends.back(), [](error_code) {});
+    asiofy::libssh::async_handle_key_exchange(
+        server, [this, &server](error_code ec) { if (!ec) lb.serve(server); });
+  }
+
+  error_code connect(bool trusted = true)
+  {
+    if (trusted)
+      lb.trust(target.native_handle(), "127.0.0.1", 2222u);
+    error_code res;
+    bool done = false;
+    asiofy::libssh::async_connect_jump(lb.client, target, "127.0.0.1", 2222u, "nobody",
+                                       [&](error_code ec) { res = ec; done = true; });
+    lb.run_until([&]{ return done; });
+    return res;
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("jump");
+
+TEST_CASE("async_connect_jump connects the target through the jump host")
+{
+  jumped j;
+  REQUIRE(!j.connect());
+  CHECK(j.destination == "127.0.0.1");
+  CHECK(j.destination_port == 2222);
+  CHECK(j.target.is_connected());
+
+  // the tunnel is the first server channel, the channel of the target the second one.
+  loopback::channel_type chan{j.target};
+  error_code ec;
+  bool done = false;
+  chan.async_open_session([&](error_code ec_) { ec = ec_; done = true; });
+  j.lb.run_until([&]{ return done && (ec || j.lb.server_channels.size() == 2u); });
+  REQUIRE(!ec);
+
+  const std::string ping = "ping";
+  std::string buf(ping.size(), '\0');
+  int pending = 2;
+  auto out = chan.get_stdout();
+  auto in = j.lb.server_channels[1].get_stdout();
+  net::async_write(out, net::buffer(ping), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  net::async_read(in, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  j.lb.run_until([&]{ return pending == 0; });
+  CHECK(buf == ping);
+}
+
+TEST_CASE("async_connect_jump fails when the jump host refuses the channel")
+{
+  jumped j;
+  j.refuse = true;
+  CHECK(j.connect());
+  CHECK(j.destination == "127.0.0.1");
+  CHECK(!j.target.next_layer().is_open());
+}
+
+TEST_CASE("async_connect_jump verifies the host key of the target")
+{
+  jumped j;
+  CHECK(j.connect(false) == asiofy::libssh::make_error_code(asiofy::libssh::errc::host_key_unknown));
+}
+
+TEST_CASE("async_connect_jump can be cancelled through the jump session")
+{
+  jumped j;
+  error_code res;
+  bool done = false;
+  asiofy::libssh::async_connect_jump(j.lb.client, j.target, "127.0.0.1", 2222u, "nobody",
+                                     [&](error_code ec) { res = ec; done = true; });
+  j.lb.client.next_layer().cancel();
+  j.lb.run_until([&]{ return done; });
+  CHECK(res == net::error::operation_aborted);
+  CHECK(!j.target.next_layer().is_open());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/log.hpp>
+#include "doctest.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asiofy::libssh;
+
+TEST_SUITE_BEGIN("log");
+
+TEST_CASE("async_log_sink")
+{
+  std::mutex mtx;
+  std::vector<std::string> written;
+  {
+    async_log_sink sink{16u, [&](const log_record & rec)
+                        {
+                          std::lock_guard<std::mutex> l{mtx};
+                          written.push_back(std::string(rec.function) + ": " + rec.message);
+                        }};
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++)
+      producers.emplace_back([&]
+      {
+        for (int i = 0; i < 1000; i++)
+          sink.push(SSH_LOG_PROTOCOL, "ssh_packet_send", "sending a packet");
+      });
+    for (auto & p : producers)
+      p.join();
+
+    // the background thread writes everything it didn't drop.
+    while (sink.written() + sink.dropped() < 4000u)
+      std::this_thread::yield();
+    CHECK(sink.written() + sink.dropped() == 4000u);
+    CHECK(sink.push(SSH_LOG_WARNING, nullptr, std::string(1000u, 'x').c_str()));
+  }
+
+  REQUIRE(!written.empty());
+  CHECK(written.front() == "ssh_packet_send: sending a packet");
+  CHECK(written.back().size() == 2u + 511u);
+}
+
+TEST_CASE("async_log_sink gets the log of libssh while installed")
+{
+  const int level = ssh_get_log_level();
+  ssh_set_log_level(SSH_LOG_WARNING);
+  const auto previous = ssh_get_log_callback();
+
+  std::mutex mtx;
+  std::vector<std::string> written;
+  {
+    async_log_sink sink{16u, [&](const log_record & rec)
+                        {
+                          std::lock_guard<std::mutex> l{mtx};
+                          written.push_back(rec.message);
+                        }};
+    sink.install();
+    const auto installed = ssh_get_log_callback();
+    CHECK(installed != previous);
+    CHECK(ssh_get_log_userdata() == &sink);
+
+    _ssh_log(SSH_LOG_WARNING, "log_test", "through %s", "libssh");
+    while (sink.written() < 1u)
+      std::this_thread::yield();
+
+    async_log_sink::uninstall();
+    CHECK(ssh_get_log_callback() != installed);
+    CHECK(ssh_get_log_userdata() == nullptr);
+
+    // goes to stderr now, not to the sink.
+    _ssh_log(SSH_LOG_WARNING, "log_test", "after uninstall");
+  }
+
+  // the sink writes everything it got before it's destroyed.
+  REQUIRE(written.size() == 1u);
+  CHECK(written.front().find("through libssh") != std::string::npos);
+  ssh_set_log_level(level);
+}
+
+TEST_SUITE_END();
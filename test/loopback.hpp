@@ -0,0 +1,286 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASIOFY_TEST_LOOPBACK_HPP
+#define ASIOFY_TEST_LOOPBACK_HPP
+
+#include <asiofy/libssh/basic_channel.hpp>
+#include <asiofy/libssh/basic_session.hpp>
+#include <asiofy/libssh/bind.hpp>
+#include <asiofy/libssh/message.hpp>
+#include <asiofy/libssh/server.hpp>
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/local/connect_pair.hpp>
+#include <asio/local/stream_protocol.hpp>
+#else
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+namespace net = asiofy::net;
+
+/// A client & a server session in one process, connected through a socketpair.
+/** No network, no sshd & no keys on disk: the host key gets generated, the client skips host key verification
+ * and the server accepts every authentication, every session & direct-tcpip channel and every channel request.
+ * Everything runs on one io_context, so tests & benchmarks are deterministic.
+ *
+ * Clients that connect on their own, e.g. through a pool, can reach the same server on `listen()`'s port,
+ * after `trust` gave them a known_hosts file & an identity in a temporary directory. */
+struct loopback
+{
+  using session_type = asiofy::libssh::basic_session<net::io_context::executor_type>;
+  using channel_type = asiofy::libssh::basic_channel<net::io_context::executor_type>;
+  using bind_type    = asiofy::libssh::basic_bind<net::io_context::executor_type>;
+
+  net::io_context ctx;
+  bind_type bind{ctx.get_executor()};
+  session_type client{ctx.get_executor()};
+  session_type server{ctx.get_executor()};
+  /// The server sessions accepted on the port of `listen()`.
+  std::deque<session_type> accepted;
+  /// The channels the server accepted, in the order they were opened.
+  std::deque<channel_type> server_channels;
+  /// Sees every message of a served session first, returns true if it replied to it.
+  std::function<bool(session_type &, ssh_message)> on_message;
+
+  /// The bind options, e.g. `asiofy::libssh::ciphers_s_c`, get applied before the server session is accepted.
+  template<typename ... BindOptions>
+  explicit loopback(ssh_keytypes_e key_type = SSH_KEYTYPE_ED25519, const BindOptions & ... bind_options)
+  {
+    ssh_key key = nullptr;
+    if (ssh_pki_generate(key_type, 0, &key) != SSH_OK)
+      throw std::runtime_error("ssh_pki_generate failed");
+    // the bind takes ownership of the key.
+    bind.options_set(SSH_BIND_OPTIONS_IMPORT_KEY, key);
+    host_key_ = key;
+
+    if (!asiofy::libssh::apply_config(bind, asiofy::libssh::make_options(bind_options...)))
+      throw std::runtime_error("invalid bind option");
+
+    net::local::stream_protocol::socket client_end{ctx}, server_end{ctx};
+    net::local::connect_pair(client_end, server_end);
+
+    // both sessions take ownership of their descriptor.
+    client.next_layer().assign(net::generic::stream_protocol(net::local::stream_protocol()), client_end.release());
+    bind.accept_fd(server, server_end.release());
+  }
+
+  ~loopback()
+  {
+    if (dir_.empty())
+      return;
+    for (const char * name : {"/known_hosts", "/id_ed25519", "/id_ed25519.pub"})
+      std::remove((dir_ + name).c_str());
+    ::rmdir(dir_.c_str());
+  }
+
+  /// Run the io_context until `done()` returns true.
+  template<typename Predicate>
+  void run_until(Predicate done)
+  {
+    ctx.restart();
+    while (!done())
+      if (ctx.run_one() == 0u)
+        throw std::runtime_error("loopback ran out of work");
+  }
+
+  /// Perform the key exchange on both ends.
+  void handshake()
+  {
+    asiofy::libssh::error_code client_ec, server_ec;
+    int pending = 2;
+    client.async_connect([&](asiofy::libssh::error_code ec) { client_ec = ec; pending--; });
+    asiofy::libssh::async_handle_key_exchange(server, [&](asiofy::libssh::error_code ec) { server_ec = ec; pending--; });
+    run_until([&]{ return pending == 0; });
+    if (client_ec)
+      throw asiofy::libssh::system_error(client_ec, "client key exchange");
+    if (server_ec)
+      throw asiofy::libssh::system_error(server_ec, "server key exchange");
+  }
+
+  /// Start answering the messages of the client, until it disconnects.
+  void serve()
+  {
+    serve(server);
+  }
+
+  void serve(session_type & sess)
+  {
+    asiofy::libssh::async_get_message(sess, serve_op{this, &sess});
+  }
+
+  /// Accept connections on a port of 127.0.0.1, every one gets a session in `accepted`, that is served.
+  unsigned short listen()
+  {
+    acceptor_.open(net::ip::tcp::v4());
+    acceptor_.bind(net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u));
+    acceptor_.listen();
+    accept();
+    return acceptor_.local_endpoint().port();
+  }
+
+  /// Stop accepting connections on the port of `listen()`.
+  void close_listener()
+  {
+    acceptor_.close();
+  }
+
+  /// Let `sess` verify the host key of `host:port` and authenticate with publickey, like a real client would.
+  void trust(ssh_session sess, const char * host, unsigned short port)
+  {
+    if (dir_.empty())
+      make_credentials();
+
+    char * b64 = nullptr;
+    if (ssh_pki_export_pubkey_base64(host_key_, &b64) != SSH_OK)
+      throw std::runtime_error("ssh_pki_export_pubkey_base64 failed");
+    std::ofstream known_hosts{dir_ + "/known_hosts", std::ios::app};
+    // the port is only part of the entry if it isn't the default one.
+    if (port == 22u)
+      known_hosts << host;
+    else
+      known_hosts << '[' << host << "]:" << port;
+    known_hosts << ' ' << ssh_key_type_to_char(ssh_key_type(host_key_)) << ' ' << b64 << '\n';
+    ssh_string_free_char(b64);
+
+    ssh_options_set(sess, SSH_OPTIONS_KNOWNHOSTS, (dir_ + "/known_hosts").c_str());
+    ssh_options_set(sess, SSH_OPTIONS_ADD_IDENTITY, (dir_ + "/id_ed25519").c_str());
+  }
+
+  /// Key exchange, start serving & authenticate the client with `none`.
+  void connect()
+  {
+    handshake();
+    serve();
+
+    asiofy::libssh::error_code ec;
+    bool done = false;
+    asiofy::libssh::detail::async_auth_op(
+        client, [](ssh_session sess) { return ssh_userauth_none(sess, nullptr); }, nullptr,
+        [&](asiofy::libssh::error_code ec_) { ec = ec_; done = true; });
+    run_until([&]{ return done; });
+    if (ec)
+      throw asiofy::libssh::system_error(ec, "client authentication");
+  }
+
+  /// Open a session channel from the client, returns the server's end in `server_channels.back()`.
+  channel_type open_channel()
+  {
+    channel_type chan{client};
+    asiofy::libssh::error_code ec;
+    bool done = false;
+    chan.async_open_session([&](asiofy::libssh::error_code ec_) { ec = ec_; done = true; });
+    const auto opened = server_channels.size() + 1u;
+    run_until([&]{ return done && (ec || server_channels.size() == opened); });
+    if (ec)
+      throw asiofy::libssh::system_error(ec, "open channel");
+    return chan;
+  }
+
+ private:
+  ssh_key host_key_ = nullptr;
+  net::ip::tcp::acceptor acceptor_{ctx};
+  std::string dir_;
+
+  void accept()
+  {
+    acceptor_.async_accept(
+        [this](asiofy::libssh::error_code ec, net::ip::tcp::socket sock)
+        {
+          if (ec)
+            return;
+          accepted.emplace_back(ctx.get_executor());
+          auto & sess = accepted.back();
+          bind.accept_fd(sess, sock.release());
+          asiofy::libssh::async_handle_key_exchange(
+              sess, [this, &sess](asiofy::libssh::error_code ec) { if (!ec) serve(sess); });
+          accept();
+        });
+  }
+
+  void make_credentials()
+  {
+    const char * tmp = std::getenv("TMPDIR");
+    std::string dir = std::string(tmp ? tmp : "/tmp") + "/asiofy-XXXXXX";
+    if (::mkdtemp(&dir[0]) == nullptr)
+      throw std::runtime_error("mkdtemp failed");
+    dir_ = dir;
+
+    ssh_key key = nullptr;
+    if (ssh_pki_generate(SSH_KEYTYPE_ED25519, 0, &key) != SSH_OK)
+      throw std::runtime_error("ssh_pki_generate failed");
+    const int res_priv = ssh_pki_export_privkey_file(key, nullptr, nullptr, nullptr, (dir_ + "/id_ed25519").c_str());
+    const int res_pub  = ssh_pki_export_pubkey_file(key, (dir_ + "/id_ed25519.pub").c_str());
+    ssh_key_free(key);
+    if (res_priv != SSH_OK || res_pub != SSH_OK)
+      throw std::runtime_error("exporting the identity failed");
+  }
+
+  void reply(session_type & sess, ssh_message msg)
+  {
+    switch (ssh_message_type(msg))
+    {
+      case SSH_REQUEST_AUTH:
+        // a publickey without a signature only asks if the key would be accepted.
+        if (ssh_message_subtype(msg) == SSH_AUTH_METHOD_PUBLICKEY
+            && ssh_message_auth_publickey_state(msg) == SSH_PUBLICKEY_STATE_NONE)
+          ssh_message_auth_reply_pk_ok_simple(msg);
+        else
+          ssh_message_auth_reply_success(msg, 0);
+        break;
+      case SSH_REQUEST_CHANNEL_OPEN:
+        if (ssh_message_subtype(msg) == SSH_CHANNEL_SESSION || ssh_message_subtype(msg) == SSH_CHANNEL_DIRECT_TCPIP)
+        {
+          if (ssh_channel chan = ssh_message_channel_request_open_reply_accept(msg))
+          {
+            server_channels.emplace_back(sess, chan);
+            break;
+          }
+        }
+        ssh_message_reply_default(msg);
+        break;
+      case SSH_REQUEST_CHANNEL:
+        ssh_message_channel_request_reply_success(msg);
+        break;
+      default:
+        ssh_message_reply_default(msg);
+    }
+  }
+
+  struct serve_op
+  {
+    loopback * this_;
+    session_type * sess;
+
+    void operator()(asiofy::libssh::error_code ec, asiofy::libssh::message_handle msg)
+    {
+      if (ec)
+        return;
+
+      if (!this_->on_message || !this_->on_message(*sess, msg.get()))
+        this_->reply(*sess, msg.get());
+      asiofy::libssh::async_get_message(*sess, std::move(*this));
+    }
+  };
+};
+
+#endif //ASIOFY_TEST_LOOPBACK_HPP
@@ -5,6 +5,3 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
-
-#include <boost/sqlite.hpp>
-#include <boost/sqlite/src.hpp>
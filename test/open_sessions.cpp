@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+#include <set>
+#include <vector>
+
+using asiofy::libssh::error_code;
+
+TEST_SUITE_BEGIN("open_sessions");
+
+TEST_CASE("async_open_sessions opens channels that all carry data")
+{
+  loopback lb;
+  lb.connect();
+
+  std::vector<loopback::channel_type> chans;
+  error_code result;
+  std::size_t opened = 0u;
+  bool done = false;
+  asiofy::libssh::async_open_sessions(
+      lb.client, 4u,
+      [&](error_code ec, loopback::channel_type chan)
+      {
+        CHECK(!ec);
+        chans.push_back(std::move(chan));
+      },
+      [&](error_code ec, std::size_t n) { result = ec; opened = n; done = true; });
+  lb.run_until([&]{ return done && lb.server_channels.size() == 4u; });
+
+  CHECK(!result);
+  CHECK(opened == 4u);
+  REQUIRE(chans.size() == 4u);
+
+  // every channel reaches a server end of its own.
+  const std::vector<std::string> payloads{"a!", "b!", "c!", "d!"};
+  std::vector<std::string> bufs(4u, std::string(2u, '\0'));
+  std::set<std::string> received;
+  // the composed operations only hold references to the streams.
+  std::vector<loopback::channel_type::stdreader> outs, ins;
+  outs.reserve(4u);
+  ins.reserve(4u);
+  int pending = 8;
+  for (std::size_t i = 0u; i < 4u; i++)
+  {
+    outs.push_back(chans[i].get_stdout());
+    net::async_write(outs.back(), net::buffer(payloads[i]),
+                     [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    ins.push_back(lb.server_channels[i].get_stdout());
+    net::async_read(ins.back(), net::buffer(&bufs[i][0], 2u),
+                    [&, i](error_code ec, std::size_t) { CHECK(!ec); received.insert(bufs[i]); pending--; });
+  }
+  lb.run_until([&]{ return pending == 0; });
+  CHECK(received == std::set<std::string>(payloads.begin(), payloads.end()));
+}
+
+TEST_CASE("async_open_sessions reports every channel the server refuses")
+{
+  loopback lb;
+  lb.on_message = [](loopback::session_type &, ssh_message msg)
+  {
+    if (ssh_message_type(msg) != SSH_REQUEST_CHANNEL_OPEN)
+      return false;
+    ssh_message_reply_default(msg);
+    return true;
+  };
+  lb.connect();
+
+  std::size_t failed = 0u, opened = 0u;
+  error_code result;
+  bool done = false;
+  asiofy::libssh::async_open_sessions(
+      lb.client, 3u,
+      [&](error_code ec, loopback::channel_type) { if (ec) failed++; },
+      [&](error_code ec, std::size_t n) { result = ec; opened = n; done = true; });
+  lb.run_until([&]{ return done; });
+
+  CHECK(result);
+  CHECK(failed == 3u);
+  CHECK(opened == 0u);
+  CHECK(lb.server_channels.empty());
+}
+
+TEST_CASE("async_open_sessions can be cancelled")
+{
+  loopback lb;
+  lb.connect();
+
+  std::size_t callbacks = 0u, opened = 0u;
+  error_code result;
+  bool done = false;
+  asiofy::libssh::async_open_sessions(
+      lb.client, 2u,
+      [&](error_code, loopback::channel_type) { callbacks++; },
+      [&](error_code ec, std::size_t n) { result = ec; opened = n; done = true; });
+  lb.client.next_layer().cancel();
+  lb.run_until([&]{ return done; });
+
+  CHECK(result == net::error::operation_aborted);
+  CHECK(opened == 0u);
+  CHECK(callbacks == 0u);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/bind.hpp>
+#include <asiofy/libssh/options.hpp>
+#include "doctest.h"
+
+#include <string>
+#include <vector>
+
+using namespace asiofy::libssh;
+
+// the checks that need to happen at compile time
+static_assert(detail::is_option_value<unsigned, unsigned short>::value, "");
+static_assert(detail::is_option_value<long long, unsigned>::value, "");
+static_assert(!detail::is_option_value<unsigned, int>::value, "");
+static_assert(!detail::is_option_value<int, unsigned>::value, "");
+static_assert(!detail::is_option_value<int, long long>::value, "");
+static_assert(detail::is_option_value<const char *, const char(&)[5]>::value, "");
+static_assert(!detail::is_option_value<int, bool>::value, "");
+static_assert(!detail::is_option_value<bool, int>::value, "");
+static_assert(!detail::is_option_value<int, double>::value, "");
+static_assert(!detail::is_option_value<const char *, std::nullptr_t>::value, "");
+static_assert(!detail::is_option_value<const char *, std::string>::value, "");
+
+constexpr auto client_options = make_options(options::user{"deploy"}, options::port{2222u},
+                                             options::add_identity{"id_a"}, options::add_identity{"id_b"});
+static_assert(client_options.valid(), "");
+static_assert(client_options.size() == 4u, "");
+static_assert(!make_options(options::user{}).valid(), "");
+
+constexpr auto server_options = make_options(bindaddr{"127.0.0.1"}, bindport{0u}, process_config{false});
+static_assert(server_options.valid(), "");
+
+TEST_SUITE_BEGIN("options");
+
+TEST_CASE("option_set applies to many sessions")
+{
+  std::vector<session_handle> sessions;
+  for (int i = 0; i < 16; i++)
+    sessions.emplace_back(ssh_new());
+
+  CHECK(apply_config_all(sessions, client_options) == sessions.size());
+
+  for (auto & sess : sessions)
+  {
+    char * user = nullptr;
+    REQUIRE(ssh_options_get(sess.get(), SSH_OPTIONS_USER, &user) == SSH_OK);
+    CHECK(std::string(user) == "deploy");
+    ssh_string_free_char(user);
+
+    unsigned port = 0u;
+    REQUIRE(ssh_options_get_port(sess.get(), &port) == SSH_OK);
+    CHECK(port == 2222u);
+  }
+}
+
+TEST_CASE("option_set stops at the first failure")
+{
+  session_handle sess{ssh_new()};
+  CHECK(apply_config(sess, make_options()));
+  CHECK(!apply_config(sess, make_options(options::user{"someone"}, options::log_verbosity_str{"not-a-level"},
+                                         options::host{"localhost"})));
+
+  char * host = nullptr;
+  CHECK(ssh_options_get(sess.get(), SSH_OPTIONS_HOST, &host) != SSH_OK);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/reverse_forward.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+using forwarder_type = asiofy::libssh::basic_reverse_forwarder<net::io_context::executor_type>;
+
+namespace
+{
+
+// the client side of `ssh -R` is plain libssh, which gets driven by waiting for the socket in between calls.
+struct reverse_forwarded
+{
+  loopback lb;
+  forwarder_type fwd{lb.server};
+  std::deque<loopback::channel_type> channels;
+
+  reverse_forwarded()
+  {
+    lb.on_message = [this](loopback::session_type &, ssh_message msg) { return fwd.handle_message(msg); };
+    lb.connect();
+  }
+
+  // the forwarded connections hold channels of the server session, so they need to finish before it's gone.
+  ~reverse_forwarded()
+  {
+    fwd.close();
+    error_code ig;
+    asiofy::libssh::error_info ei;
+    for (auto & chan : channels)
+      if (chan.is_open())
+        chan.close(ig, ei);
+    lb.ctx.restart();
+    lb.ctx.run_for(std::chrono::milliseconds(200));
+  }
+
+  void wait_for_client()
+  {
+    bool woken = false;
+    lb.client.next_layer().async_wait(net::socket_base::wait_read, [&](error_code) { woken = true; });
+    lb.run_until([&]{ return woken; });
+  }
+
+  int listen(const char * address, int & bound)
+  {
+    int res;
+    while ((res = ssh_channel_listen_forward(lb.client.native_handle(), address, 0, &bound)) == SSH_AGAIN)
+      wait_for_client();
+    return res;
+  }
+
+  int cancel(const char * address, int port)
+  {
+    int res;
+    while ((res = ssh_channel_cancel_forward(lb.client.native_handle(), address, port)) == SSH_AGAIN)
+      wait_for_client();
+    return res;
+  }
+
+  // connects to `port` & returns the stream of the channel the server opened for it.
+  loopback::channel_type::stdreader connect(net::ip::tcp::socket & sock, int port)
+  {
+    sock.connect(net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), static_cast<unsigned short>(port)));
+    ssh_channel chan;
+    int dest_port = 0;
+    while ((chan = ssh_channel_accept_forward(lb.client.native_handle(), 0, &dest_port)) == nullptr)
+      wait_for_client();
+    CHECK(dest_port == port);
+    channels.emplace_back(lb.client, chan);
+    return channels.back().get_stdout();
+  }
+
+  template<typename Source, typename Sink>
+  std::string transfer(Source & source, Sink & sink, const std::string & data)
+  {
+    std::string buf(data.size(), '\0');
+    int pending = 2;
+    net::async_write(source, net::buffer(data), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    net::async_read(sink, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    return buf;
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("reverse_forward");
+
+TEST_CASE("reverse_forwarder forwards connections back to the client")
+{
+  reverse_forwarded rf;
+  int port = 0;
+  REQUIRE(rf.listen("127.0.0.1", port) == SSH_OK);
+  CHECK(port != 0);
+  CHECK(rf.fwd.size() == 1u);
+
+  net::ip::tcp::socket first{rf.lb.ctx}, second{rf.lb.ctx};
+  auto first_chan = rf.connect(first, port);
+  CHECK(rf.transfer(first, first_chan, "request") == "request");
+  CHECK(rf.transfer(first_chan, first, "response") == "response");
+
+  auto second_chan = rf.connect(second, port);
+  CHECK(rf.transfer(second, second_chan, "again") == "again");
+}
+
+TEST_CASE("reverse_forwarder refuses what it can't listen on & stops on cancel")
+{
+  reverse_forwarded rf;
+  int port = 0;
+  CHECK(rf.listen("not an address", port) == SSH_ERROR);
+  CHECK(rf.fwd.size() == 0u);
+
+  REQUIRE(rf.listen("127.0.0.1", port) == SSH_OK);
+  CHECK(rf.cancel("127.0.0.1", port) == SSH_OK);
+  CHECK(rf.fwd.size() == 0u);
+  // unknown by now.
+  CHECK(rf.cancel("127.0.0.1", port) == SSH_ERROR);
+
+  net::ip::tcp::socket sock{rf.lb.ctx};
+  error_code ec;
+  sock.connect(net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), static_cast<unsigned short>(port)), ec);
+  CHECK(ec == net::error::connection_refused);
+}
+
+TEST_CASE("reverse_forwarder keeps open connections when closed")
+{
+  reverse_forwarded rf;
+  int port = 0;
+  REQUIRE(rf.listen("127.0.0.1", port) == SSH_OK);
+
+  net::ip::tcp::socket sock{rf.lb.ctx};
+  auto chan = rf.connect(sock, port);
+  rf.fwd.close();
+  CHECK(rf.fwd.size() == 0u);
+
+  CHECK(rf.transfer(sock, chan, "still") == "still");
+  CHECK(rf.transfer(chan, sock, "open") == "open");
+}
+
+TEST_SUITE_END();
@@ -4,3 +4,64 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+TEST_SUITE_BEGIN("session");
+
+TEST_CASE("loopback key exchange")
+{
+  loopback lb;
+  lb.handshake();
+  CHECK(lb.client.is_connected());
+  CHECK(lb.server.is_connected());
+}
+
+TEST_CASE("loopback channel round trip")
+{
+  loopback lb;
+  lb.connect();
+  auto chan = lb.open_channel();
+  REQUIRE(lb.server_channels.size() == 1u);
+  auto & peer = lb.server_channels.front();
+
+  const char ping[] = "ping";
+  char buf[sizeof(ping)] = {};
+  asiofy::libssh::error_code write_ec, read_ec;
+  int pending = 2;
+
+  auto out = chan.get_stdout();
+  auto in = peer.get_stdout();
+  net::async_write(out, net::buffer(ping),
+                   [&](asiofy::libssh::error_code ec, std::size_t) { write_ec = ec; pending--; });
+  net::async_read(in, net::buffer(buf),
+                  [&](asiofy::libssh::error_code ec, std::size_t) { read_ec = ec; pending--; });
+  lb.run_until([&]{ return pending == 0; });
+
+  CHECK(!write_ec);
+  CHECK(!read_ec);
+  CHECK(std::string(buf) == ping);
+
+  CHECK(chan.traffic().bytes_out == sizeof(ping));
+  CHECK(peer.traffic().bytes_in  == sizeof(ping));
+  CHECK(lb.client.traffic().bytes_out == sizeof(ping));
+  CHECK(lb.server.traffic().bytes_in  == sizeof(ping));
+  CHECK(peer.traffic().time_to_first_byte.count() > 0);
+
+  const auto snap = asiofy::libssh::snapshot_traffic(lb.server_channels);
+  CHECK(snap.count == 1u);
+  CHECK(snap.total.bytes_in == sizeof(ping));
+  REQUIRE(snap.heaviest.size() == 1u);
+  CHECK(snap.heaviest.front().first == peer.id());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/session_pool.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+using pool_type = asiofy::libssh::basic_session_pool<net::io_context::executor_type>;
+
+namespace
+{
+
+pool_type make_pool(loopback & lb, unsigned short port, asiofy::libssh::session_pool_options options = {})
+{
+  options.configure = [&lb, port](ssh_session sess) { lb.trust(sess, "127.0.0.1", port); };
+  return pool_type{lb.ctx.get_executor(), options};
+}
+
+// sends `data` through `chan` & checks that it arrives at `peer`.
+void round_trip(loopback & lb, loopback::channel_type & chan, loopback::channel_type & peer, const std::string & data)
+{
+  std::string buf(data.size(), '\0');
+  int pending = 2;
+  auto out = chan.get_stdout();
+  auto in = peer.get_stdout();
+  net::async_write(out, net::buffer(data), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  net::async_read(in, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  lb.run_until([&]{ return pending == 0; });
+  CHECK(buf == data);
+}
+
+}
+
+TEST_SUITE_BEGIN("session_pool");
+
+TEST_CASE("session_pool shares one session between channels")
+{
+  loopback lb;
+  const auto port = lb.listen();
+  auto pool = make_pool(lb, port);
+  const asiofy::libssh::session_key key{"127.0.0.1", port, "nobody"};
+
+  pool_type::channel_type first, second;
+  int pending = 2;
+  pool.async_acquire(key, [&](error_code ec, pool_type::channel_type chan) { CHECK(!ec); first = std::move(chan); pending--; });
+  pool.async_acquire(key, [&](error_code ec, pool_type::channel_type chan) { CHECK(!ec); second = std::move(chan); pending--; });
+  lb.run_until([&]{ return pending == 0 && lb.server_channels.size() == 2u; });
+
+  REQUIRE(first);
+  REQUIRE(second);
+  CHECK(pool.size() == 1u);
+  CHECK(lb.accepted.size() == 1u);
+  CHECK(&first->session() == &second->session());
+
+  round_trip(lb, *first,  lb.server_channels[0], "first");
+  round_trip(lb, *second, lb.server_channels[1], "second");
+
+  // a returned slot gets reused, without connecting again.
+  first.reset();
+  pool_type::channel_type third;
+  pool.async_acquire(key, [&](error_code ec, pool_type::channel_type chan) { CHECK(!ec); third = std::move(chan); });
+  lb.run_until([&]{ return third && lb.server_channels.size() == 3u; });
+  CHECK(pool.size() == 1u);
+  CHECK(lb.accepted.size() == 1u);
+  round_trip(lb, *third, lb.server_channels[2], "third");
+}
+
+TEST_CASE("session_pool reports a host it can't connect to")
+{
+  loopback lb;
+  unsigned short refused_port;
+  {
+    net::ip::tcp::acceptor closed{lb.ctx, net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u)};
+    refused_port = closed.local_endpoint().port();
+  }
+  auto pool = make_pool(lb, refused_port);
+
+  error_code result;
+  bool done = false;
+  pool.async_acquire({"127.0.0.1", refused_port, "nobody"},
+                     [&](error_code ec, pool_type::channel_type chan)
+                     {
+                       CHECK(!chan);
+                       result = ec;
+                       done = true;
+                     });
+  lb.run_until([&]{ return done; });
+
+  CHECK(result == net::error::connection_refused);
+  // the broken session got evicted, so the next acquire starts over.
+  CHECK(pool.size() == 0u);
+}
+
+TEST_CASE("session_pool aborts waiting acquires when closed")
+{
+  loopback lb;
+  const auto port = lb.listen();
+  asiofy::libssh::session_pool_options options;
+  options.max_sessions_per_key = 1u;
+  options.max_channels_per_session = 1u;
+  auto pool = make_pool(lb, port, options);
+  const asiofy::libssh::session_key key{"127.0.0.1", port, "nobody"};
+
+  pool_type::channel_type held;
+  pool.async_acquire(key, [&](error_code ec, pool_type::channel_type chan) { CHECK(!ec); held = std::move(chan); });
+  lb.run_until([&]{ return held && lb.server_channels.size() == 1u; });
+
+  // no slot left, so this one waits until the pool gets closed.
+  error_code result;
+  bool done = false;
+  pool.async_acquire(key, [&](error_code ec, pool_type::channel_type chan)
+                     {
+                       CHECK(!chan);
+                       result = ec;
+                       done = true;
+                     });
+  lb.ctx.poll();
+  CHECK(!done);
+  pool.close();
+  lb.run_until([&]{ return done; });
+  CHECK(result == net::error::operation_aborted);
+
+  // the channel in use keeps its session alive.
+  round_trip(lb, *held, lb.server_channels[0], "still open");
+}
+
+TEST_SUITE_END();
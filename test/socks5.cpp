@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/socks5.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+#include <vector>
+
+using asiofy::libssh::error_code;
+using acceptor_type = net::basic_socket_acceptor<net::ip::tcp, net::io_context::executor_type>;
+using bytes = std::vector<unsigned char>;
+
+namespace
+{
+
+struct proxied
+{
+  loopback lb;
+  acceptor_type acceptor{lb.ctx.get_executor(),
+                         net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"), 0u)};
+  std::string destination;
+  int destination_port = 0;
+  bool refuse = false;
+
+  error_code result;
+  bool done = false;
+
+  proxied()
+  {
+    lb.on_message = [this](loopback::session_type &, ssh_message msg)
+    {
+      if (ssh_message_type(msg) != SSH_REQUEST_CHANNEL_OPEN || ssh_message_subtype(msg) != SSH_CHANNEL_DIRECT_TCPIP)
+        return false;
+      destination = ssh_message_channel_request_open_destination(msg);
+      destination_port = ssh_message_channel_request_open_destination_port(msg);
+      if (!refuse)
+        return false;
+      ssh_message_reply_default(msg);
+      return true;
+    };
+    lb.connect();
+    asiofy::libssh::async_forward_socks5(lb.client, acceptor, [this](error_code ec) { result = ec; done = true; });
+  }
+
+  // the proxied connections hold channels of the client session, so they need to finish before it's gone.
+  ~proxied()
+  {
+    error_code ig;
+    asiofy::libssh::error_info ei;
+    acceptor.close(ig);
+    for (auto & chan : lb.server_channels)
+      if (chan.is_open())
+        chan.close(ig, ei);
+    lb.ctx.restart();
+    lb.ctx.run_for(std::chrono::milliseconds(200));
+  }
+
+  net::ip::tcp::socket connect()
+  {
+    net::ip::tcp::socket sock{lb.ctx};
+    sock.connect(acceptor.local_endpoint());
+    return sock;
+  }
+
+  // sends `request` & reads a reply of `reply_size` bytes.
+  bytes exchange(net::ip::tcp::socket & sock, const bytes & request, std::size_t reply_size)
+  {
+    bytes reply(reply_size);
+    int pending = 2;
+    net::async_write(sock, net::buffer(request), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    net::async_read(sock, net::buffer(reply), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    return reply;
+  }
+
+  error_code read_eof(net::ip::tcp::socket & sock)
+  {
+    char c;
+    error_code res;
+    bool read = false;
+    sock.async_read_some(net::buffer(&c, 1u), [&](error_code ec, std::size_t) { res = ec; read = true; });
+    lb.run_until([&]{ return read; });
+    return res;
+  }
+
+  template<typename Source, typename Sink>
+  std::string transfer(Source & source, Sink & sink, const std::string & data)
+  {
+    std::string buf(data.size(), '\0');
+    int pending = 2;
+    net::async_write(source, net::buffer(data), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    net::async_read(sink, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    return buf;
+  }
+};
+
+const bytes greeting{0x05, 0x01, 0x00};
+const bytes no_auth{0x05, 0x00};
+// CONNECT example.org:443
+const bytes connect_domain{0x05, 0x01, 0x00, 0x03, 11u,
+                           'e', 'x', 'a', 'm', 'p', 'l', 'e', '.', 'o', 'r', 'g', 0x01, 0xBB};
+
+}
+
+TEST_SUITE_BEGIN("socks5");
+
+TEST_CASE("async_forward_socks5 connects to the requested destination")
+{
+  proxied px;
+  auto sock = px.connect();
+  CHECK(px.exchange(sock, greeting, 2u) == no_auth);
+
+  const auto reply = px.exchange(sock, connect_domain, 10u);
+  CHECK(reply[0] == 0x05);
+  CHECK(reply[1] == 0x00);
+  CHECK(px.destination == "example.org");
+  CHECK(px.destination_port == 443);
+
+  REQUIRE(px.lb.server_channels.size() == 1u);
+  auto peer = px.lb.server_channels.front().get_stdout();
+  CHECK(px.transfer(sock, peer, "request") == "request");
+  CHECK(px.transfer(peer, sock, "response") == "response");
+
+  // an ipv4 destination works the same way.
+  auto other = px.connect();
+  CHECK(px.exchange(other, greeting, 2u) == no_auth);
+  CHECK(px.exchange(other, {0x05, 0x01, 0x00, 0x01, 10u, 0u, 0u, 1u, 0x00, 0x50}, 10u)[1] == 0x00);
+  CHECK(px.destination == "10.0.0.1");
+  CHECK(px.destination_port == 80);
+}
+
+TEST_CASE("async_forward_socks5 replies with an error to what it can't connect")
+{
+  proxied px;
+
+  SUBCASE("no acceptable method")
+  {
+    auto sock = px.connect();
+    CHECK(px.exchange(sock, {0x05, 0x01, 0x02}, 2u) == bytes{0x05, 0xFF});
+    CHECK(px.read_eof(sock) == net::error::eof);
+  }
+
+  SUBCASE("unsupported command")
+  {
+    auto sock = px.connect();
+    CHECK(px.exchange(sock, greeting, 2u) == no_auth);
+    // BIND
+    CHECK(px.exchange(sock, {0x05, 0x02, 0x00, 0x01, 127u, 0u, 0u, 1u, 0x00, 0x50}, 10u)[1] == 0x07);
+    CHECK(px.read_eof(sock) == net::error::eof);
+  }
+
+  SUBCASE("refused by the server")
+  {
+    px.refuse = true;
+    auto sock = px.connect();
+    CHECK(px.exchange(sock, greeting, 2u) == no_auth);
+    CHECK(px.exchange(sock, connect_domain, 10u)[1] == 0x05);
+    CHECK(px.read_eof(sock) == net::error::eof);
+    CHECK(px.destination == "example.org");
+  }
+
+  CHECK(px.lb.server_channels.empty());
+  CHECK(!px.done);
+}
+
+TEST_CASE("async_forward_socks5 ends when the acceptor gets closed")
+{
+  proxied px;
+  auto sock = px.connect();
+  CHECK(px.exchange(sock, greeting, 2u) == no_auth);
+  CHECK(px.exchange(sock, connect_domain, 10u)[1] == 0x00);
+  REQUIRE(px.lb.server_channels.size() == 1u);
+  auto peer = px.lb.server_channels.front().get_stdout();
+
+  px.acceptor.close();
+  px.lb.run_until([&]{ return px.done; });
+  CHECK(px.result == net::error::operation_aborted);
+
+  // connections that are already open keep forwarding.
+  CHECK(px.transfer(sock, peer, "still open") == "still open");
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/stats.hpp>
+#include "doctest.h"
+
+#include <vector>
+
+using namespace asiofy::libssh;
+using std::chrono::nanoseconds;
+
+TEST_SUITE_BEGIN("stats");
+
+TEST_CASE("latency_histogram buckets")
+{
+  for (std::uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, 1ull << 62})
+  {
+    const auto b = latency_histogram::bucket_of(v);
+    CHECK(b < latency_histogram::bucket_count);
+    CHECK(latency_histogram::highest_of(b) >= v);
+    CHECK(latency_histogram::highest_of(b) - v <= v / 16u);
+    if (b > 0u)
+      CHECK(latency_histogram::highest_of(b - 1u) < v);
+  }
+}
+
+TEST_CASE("latency_histogram percentiles")
+{
+  latency_histogram h;
+  CHECK(h.percentile(99.) == nanoseconds(0));
+  for (int i = 1; i <= 1000; i++)
+    h.record(nanoseconds(i * 1000));
+
+  CHECK(h.count() == 1000u);
+  CHECK(h.max() == nanoseconds(1000000));
+  CHECK(h.mean() == nanoseconds(500500));
+
+  const auto p50 = h.percentile(50.).count(), p999 = h.percentile(99.9).count();
+  CHECK(p50  >= 500000);
+  CHECK(p50  <= 500000 + 500000 / 16);
+  CHECK(p999 >= 999000);
+  CHECK(h.percentile(100.) == h.max());
+
+  latency_histogram m;
+  m.merge(h);
+  m.merge(h);
+  CHECK(m.count() == 2000u);
+  CHECK(m.percentile(50.) == h.percentile(50.));
+}
+
+TEST_CASE("latency_recorder slow ops")
+{
+  std::vector<slow_op> slow;
+  latency_recorder rec{nanoseconds(100), [&](const slow_op & op) { slow.push_back(op); }};
+
+  rec.record(op_kind::auth, 1u, 0u, nanoseconds(50));
+  rec.record(op_kind::channel_read, 2u, 3u, nanoseconds(150));
+
+  CHECK(rec[op_kind::auth].count() == 1u);
+  CHECK(rec[op_kind::channel_read].count() == 1u);
+  CHECK(rec.slow_count() == 1u);
+  REQUIRE(slow.size() == 1u);
+  CHECK(slow.front().kind == op_kind::channel_read);
+  CHECK(slow.front().session_id == 2u);
+  CHECK(slow.front().channel_id == 3u);
+
+  CHECK(latency_recorder::current() == nullptr);
+  CHECK(rec.install() == nullptr);
+  CHECK(latency_recorder::current() == &rec);
+  {
+    latency_recorder other;
+    CHECK(other.install() == &rec);
+  }
+  CHECK(latency_recorder::current() == nullptr);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2023 Klemens Morgenstern (klemens.morgenstern@gmx.net)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <asiofy/libssh/transport.hpp>
+#include "loopback.hpp"
+#include "doctest.h"
+
+#if defined(ASIOFY_STANDALONE)
+#include <asio/read.hpp>
+#include <asio/write.hpp>
+#else
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#endif
+
+using asiofy::libssh::error_code;
+
+namespace
+{
+
+// a client that runs over an asio stream, with the server on the other end of it.
+struct transported
+{
+  loopback lb;
+  net::local::stream_protocol::socket stream{lb.ctx};
+  loopback::session_type client{lb.ctx.get_executor()};
+  loopback::session_type server{lb.ctx.get_executor()};
+
+  error_code result;
+  bool done = false;
+
+  transported()
+  {
+    net::local::stream_protocol::socket server_end{lb.ctx};
+    net::local::connect_pair(stream, server_end);
+    lb.bind.accept_fd(server, server_end.release());
+    asiofy::libssh::async_run_transport(client, stream, 4096u, [this](error_code ec) { result = ec; done = true; });
+  }
+
+  ~transported()
+  {
+    client.disconnect();
+    server.disconnect();
+    lb.ctx.restart();
+    lb.ctx.run_for(std::chrono::milliseconds(200));
+  }
+
+  void connect()
+  {
+    error_code client_ec, server_ec, auth_ec;
+    int pending = 2;
+    client.async_connect([&](error_code ec) { client_ec = ec; pending--; });
+    asiofy::libssh::async_handle_key_exchange(server, [&](error_code ec) { server_ec = ec; pending--; });
+    lb.run_until([&]{ return pending == 0; });
+    REQUIRE(!client_ec);
+    REQUIRE(!server_ec);
+    lb.serve(server);
+
+    bool authenticated = false;
+    asiofy::libssh::detail::async_auth_op(
+        client, [](ssh_session sess) { return ssh_userauth_none(sess, nullptr); }, nullptr,
+        [&](error_code ec) { auth_ec = ec; authenticated = true; });
+    lb.run_until([&]{ return authenticated; });
+    REQUIRE(!auth_ec);
+  }
+};
+
+}
+
+TEST_SUITE_BEGIN("transport");
+
+TEST_CASE("async_run_transport runs a session over a stream until it closes")
+{
+  transported t;
+  t.connect();
+
+  loopback::channel_type chan{t.client};
+  error_code ec;
+  bool opened = false;
+  chan.async_open_session([&](error_code ec_) { ec = ec_; opened = true; });
+  t.lb.run_until([&]{ return opened && (ec || t.lb.server_channels.size() == 1u); });
+  REQUIRE(!ec);
+
+  const std::string ping = "ping";
+  std::string buf(ping.size(), '\0');
+  int pending = 2;
+  auto out = chan.get_stdout();
+  auto in = t.lb.server_channels.front().get_stdout();
+  net::async_write(out, net::buffer(ping), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  net::async_read(in, net::buffer(&buf[0], buf.size()), [&](error_code ec, std::size_t) { CHECK(!ec); pending--; });
+  t.lb.run_until([&]{ return pending == 0; });
+  CHECK(buf == ping);
+  CHECK(t.client.traffic().bytes_out == ping.size());
+
+  // both ends closing forwards an eof in each direction, which ends the transport without an error.
+  t.lb.server_channels.clear();
+  t.client.disconnect();
+  t.server.disconnect();
+  t.lb.run_until([&]{ return t.done; });
+  CHECK(!t.result);
+}
+
+TEST_CASE("async_run_transport fails on a session that is already connected")
+{
+  loopback lb;
+  net::local::stream_protocol::socket stream{lb.ctx}, other{lb.ctx};
+  net::local::connect_pair(stream, other);
+
+  error_code result;
+  bool done = false;
+  asiofy::libssh::async_run_transport(lb.client, stream, [&](error_code ec) { result = ec; done = true; });
+  lb.run_until([&]{ return done; });
+  CHECK(result == net::error::already_open);
+}
+
+TEST_CASE("async_run_transport can be cancelled through the stream")
+{
+  transported t;
+  t.connect();
+
+  t.stream.cancel();
+  t.lb.run_until([&]{ return t.done; });
+  CHECK(t.result == net::error::operation_aborted);
+  CHECK(!t.stream.is_open());
+}
+
+TEST_SUITE_END();